@@ -0,0 +1,65 @@
+#include "claim_seed.h"
+#include "mbed.h"
+#include "mbed_error.h"
+#include "ethers.h"
+#include "storage.h"
+#include "DeviceKey.h"
+
+#include <string.h>
+
+// DeviceKey salt for the master secret. Per-nonce derivations use the 4 byte nonce as the
+// salt, so this can never collide with one.
+#define MASTER_SALT "claim seed master v1"
+
+// Hashed to get a claim seed. Keccak has no length extension, so a secret prefix makes a PRF.
+typedef struct {
+    uint8_t master[32];
+    uint32_t nonce;
+} seed_message_t;
+
+uint8_t seed_master[32];
+uint32_t seed_prf_start;
+bool seed_ready = false;
+
+int claim_seed_init() {
+    // Read every time the device is initialised; the first read on a new device records it
+    int ret = get_seed_prf_start(&seed_prf_start);
+    if(ret != MBED_SUCCESS) {
+        seed_ready = false;
+        return ret;
+    }
+    if(seed_ready) {
+        // The master secret never changes
+        return MBED_SUCCESS;
+    }
+
+    // DeviceKey derives at most 32 bytes at a time
+    ret = DeviceKey::get_instance().generate_derived_key((const uint8_t*)MASTER_SALT, sizeof(MASTER_SALT) - 1, seed_master, sizeof(seed_master));
+    if(ret != MBED_SUCCESS) {
+        memset(seed_master, 0, sizeof(seed_master));
+        return ret;
+    }
+    seed_ready = true;
+    return MBED_SUCCESS;
+}
+
+int claim_seed(uint32_t nonce, seed_t seed) {
+    if(!seed_ready) {
+        return MBED_ERROR_NOT_READY;
+    }
+    if(nonce < seed_prf_start) {
+        // Devices set up before PRF seeds keep the old derivation for nonces they may have used
+        return DeviceKey::get_instance().generate_derived_key((uint8_t*)&nonce, sizeof(nonce), seed, SEED_LENGTH);
+    }
+
+    seed_message_t message;
+    hash_t hash;
+    memcpy(message.master, seed_master, sizeof(seed_master));
+    message.nonce = nonce;
+    ethers_keccak256_short((uint8_t*)&message, sizeof(message), hash);
+    memcpy(seed, hash, SEED_LENGTH);
+
+    memset(&message, 0, sizeof(message));
+    memset(hash, 0, sizeof(hash));
+    return MBED_SUCCESS;
+}
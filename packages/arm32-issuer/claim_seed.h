@@ -0,0 +1,24 @@
+#ifndef CLAIM_SEED_H
+#define CLAIM_SEED_H
+
+#include <stdint.h>
+#include "types.h"
+
+/**
+ * Derives the seed of each claim code's claimant key.
+ *
+ * Seeds used to come from a DeviceKey derivation (CMAC KDF) for each nonce. Now a master secret
+ * is derived from DeviceKey once, and each seed is keccak256(master secret | nonce), truncated
+ * to SEED_LENGTH: one permutation instead of a KDF run per claim.
+ *
+ * So that a nonce always gives the same seed, the first nonce to use the new derivation is
+ * recorded in storage the first time a device runs this code, and kept when the store is
+ * reset; nonces before it keep their DeviceKey seeds.
+ */
+
+// Derives the master secret on the first call; called whenever the device is initialised
+int claim_seed_init();
+
+int claim_seed(uint32_t nonce, seed_t seed);
+
+#endif
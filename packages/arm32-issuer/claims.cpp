@@ -6,7 +6,8 @@
 #include "base32.h"
 #include "types.h"
 #include "config.h"
-#include "DeviceKey.h"
+#include "presign.h"
+#include "claim_seed.h"
 
 /**
  * RLE-encodes zero bytes in 'data', outputting the result to 'ret'.
@@ -44,60 +45,177 @@ typedef struct {
     address_t claimant;
 } auth_message_t;
 
-int get_auth_sig(privkey_t signer, address_t validator, uint8_t* data, size_t datalen, address_t claimant, sig_t sig) {
+/**
+ * Hashes the auth message for 'claimant', which is what the auth sig signs.
+ */
+static void get_auth_hash(address_t validator, uint8_t* data, size_t datalen, address_t claimant, hash_t messagehash) {
     auth_message_t message;
-    hash_t messagehash;
 
     message.prefix[0] = 0x19;
     message.prefix[1] = 0x00;
     memcpy(&message.validator, validator, sizeof(address_t));
-    ethers_keccak256(data, datalen, message.datahash);
+    ethers_keccak256_short(data, datalen, message.datahash);
     memcpy(&message.claimant, claimant, sizeof(address_t));
 
-    ethers_keccak256((uint8_t*)&message, sizeof(auth_message_t), messagehash);
-
-    if(!ethers_sign(signer, messagehash, sig)) {
-        return MBED_ERROR_FAILED_OPERATION;
-    }
-    return MBED_SUCCESS;
+    ethers_keccak256_short((uint8_t*)&message, sizeof(auth_message_t), messagehash);
 }
 
-int generate_claim_code(privkey_t issuer_key, address_t validator, uint32_t nonce, char *claimcode) {
-    claimcode_t claim;
+/**
+ * Fills in everything in 'claim' but the auth sig, and the hash the auth sig signs.
+ */
+static int build_claim(address_t validator, uint32_t nonce, claimcode_t *claim, hash_t messagehash) {
     privkey_t claimant_privkey;
     address_t claimant_address;
 
     // Copy the validator field into the claim code
-    memcpy(claim.validator, validator, sizeof(address_t));
+    memcpy(claim->validator, validator, sizeof(address_t));
 
     // Generate a claim seed
-    int ret = DeviceKey::get_instance().generate_derived_key((uint8_t*)&nonce, sizeof(nonce), claim.claimseed, SEED_LENGTH);
+    int ret = claim_seed(nonce, claim->claimseed);
     if(ret != MBED_SUCCESS) {
         return ret;
     }
 
     // Convert the seed to a private key
-    ethers_keccak256(claim.claimseed, SEED_LENGTH, claimant_privkey);
+    ethers_keccak256_short(claim->claimseed, SEED_LENGTH, claimant_privkey);
 
     // Obtain the address for the private key
-    if(!ethers_privateKeyToAddress(claimant_privkey, claimant_address)) {
+    bool ok = ethers_privateKeyToAddress(claimant_privkey, claimant_address);
+    memset(claimant_privkey, 0, sizeof(claimant_privkey));
+    if(!ok) {
         return MBED_ERROR_FAILED_OPERATION;
     }
 
     // Retrieve and encode nonce in the data field.
-    memset(claim.data, 0, 48);
-    *((uint32_t*)(claim.data+44)) = __REV(nonce);
-    claim.datalen = rle_encode(claim.data, claim.data + 16, 32);
+    memset(claim->data, 0, 48);
+    *((uint32_t*)(claim->data+44)) = __REV(nonce);
+    claim->datalen = rle_encode(claim->data, claim->data + 16, 32);
+
+    get_auth_hash(claim->validator, claim->data, claim->datalen, claimant_address, messagehash);
+    return MBED_SUCCESS;
+}
+
+int get_claim_hash(address_t validator, uint32_t nonce, hash_t messagehash) {
+    claimcode_t claim;
+    int ret = build_claim(validator, nonce, &claim, messagehash);
+    memset(claim.claimseed, 0, SEED_LENGTH);
+    return ret;
+}
 
-    // Generate the auth sig
-    ret = get_auth_sig(issuer_key, claim.validator, claim.data, claim.datalen, claimant_address, claim.auth_sig);
+int generate_claim_code(privkey_t issuer_key, address_t validator, uint32_t nonce, char *claimcode) {
+    claimcode_t claim;
+    hash_t messagehash;
+
+    int ret = build_claim(validator, nonce, &claim, messagehash);
     if(ret != MBED_SUCCESS) {
         return ret;
     }
 
+    // Generate the auth sig, from a precomputed nonce if there is one for this message
+    presig_t presig;
+    if(presign_take(nonce, messagehash, presig)) {
+        if(!ethers_signWithPresig(issuer_key, messagehash, presig, claim.auth_sig)) {
+            return MBED_ERROR_FAILED_OPERATION;
+        }
+    } else if(!ethers_sign(issuer_key, messagehash, claim.auth_sig)) {
+        return MBED_ERROR_FAILED_OPERATION;
+    }
+
     int claim_len = sizeof(claimcode_t) - 52 + claim.datalen;
     base32_encode((uint8_t*)&claim, claim_len, (uint8_t*)claimcode, CLAIMCODE_LEN);
     printf("%s\n", claimcode);
 
     return MBED_SUCCESS;
 }
+
+#define CLAIM_BATCH_SIZE 8
+
+/**
+ * The work of generate_claim_codes, in the claims and claimant_privkeys it is given, which hold
+ * secrets whether this returns an error or not.
+ */
+static int build_claim_codes(privkey_t issuer_key, address_t validator, uint32_t nonce, char *const *claimcodes, size_t count,
+                             claimcode_t *claims, privkey_t *claimant_privkeys) {
+    auth_message_t messages[CLAIM_BATCH_SIZE];
+    address_t claimant_addresses[CLAIM_BATCH_SIZE];
+    hash_t messagehashes[CLAIM_BATCH_SIZE];
+    sig_t sigs[CLAIM_BATCH_SIZE];
+    const uint8_t *data[CLAIM_BATCH_SIZE];
+    uint16_t lengths[CLAIM_BATCH_SIZE];
+    uint8_t *results[CLAIM_BATCH_SIZE];
+
+    while(count > 0) {
+        size_t batch = count < CLAIM_BATCH_SIZE ? count : CLAIM_BATCH_SIZE;
+
+        // Generate the claim seeds
+        for(size_t i = 0; i < batch; i++) {
+            uint32_t claim_nonce = nonce + i;
+            memcpy(claims[i].validator, validator, sizeof(address_t));
+            int ret = claim_seed(claim_nonce, claims[i].claimseed);
+            if(ret != MBED_SUCCESS) {
+                return ret;
+            }
+            data[i] = claims[i].claimseed;
+            lengths[i] = SEED_LENGTH;
+            results[i] = claimant_privkeys[i];
+        }
+
+        // Convert the seeds to private keys, and those to addresses
+        ethers_keccak256_multi(data, lengths, results, batch);
+        if(!ethers_privateKeysToAddresses((uint8_t*)claimant_privkeys, (uint8_t*)claimant_addresses, batch)) {
+            return MBED_ERROR_FAILED_OPERATION;
+        }
+
+        // Encode the nonces in the data fields and hash them
+        for(size_t i = 0; i < batch; i++) {
+            memset(claims[i].data, 0, 48);
+            *((uint32_t*)(claims[i].data+44)) = __REV(nonce + i);
+            claims[i].datalen = rle_encode(claims[i].data, claims[i].data + 16, 32);
+
+            messages[i].prefix[0] = 0x19;
+            messages[i].prefix[1] = 0x00;
+            memcpy(&messages[i].validator, validator, sizeof(address_t));
+            memcpy(&messages[i].claimant, claimant_addresses[i], sizeof(address_t));
+            data[i] = claims[i].data;
+            lengths[i] = claims[i].datalen;
+            results[i] = messages[i].datahash;
+        }
+        ethers_keccak256_multi(data, lengths, results, batch);
+
+        // Hash and sign the auth messages
+        for(size_t i = 0; i < batch; i++) {
+            data[i] = (uint8_t*)&messages[i];
+            lengths[i] = sizeof(auth_message_t);
+            results[i] = messagehashes[i];
+        }
+        ethers_keccak256_multi(data, lengths, results, batch);
+        if(!ethers_signDigests(issuer_key, (uint8_t*)messagehashes, (uint8_t*)sigs, batch)) {
+            return MBED_ERROR_FAILED_OPERATION;
+        }
+
+        for(size_t i = 0; i < batch; i++) {
+            memcpy(claims[i].auth_sig, sigs[i], sizeof(sig_t));
+
+            int claim_len = sizeof(claimcode_t) - 52 + claims[i].datalen;
+            base32_encode((uint8_t*)&claims[i], claim_len, (uint8_t*)claimcodes[i], CLAIMCODE_LEN);
+            printf("%s\n", claimcodes[i]);
+        }
+
+        nonce += batch;
+        claimcodes += batch;
+        count -= batch;
+    }
+
+    return MBED_SUCCESS;
+}
+
+int generate_claim_codes(privkey_t issuer_key, address_t validator, uint32_t nonce, char *const *claimcodes, size_t count) {
+    claimcode_t claims[CLAIM_BATCH_SIZE];
+    privkey_t claimant_privkeys[CLAIM_BATCH_SIZE];
+    int ret = build_claim_codes(issuer_key, validator, nonce, claimcodes, count, claims, claimant_privkeys);
+    memset(claimant_privkeys, 0, sizeof(claimant_privkeys));
+    for(size_t i = 0; i < CLAIM_BATCH_SIZE; i++) {
+        memset(claims[i].claimseed, 0, SEED_LENGTH);
+    }
+    return ret;
+}
@@ -18,4 +18,18 @@ typedef struct {
 
 int generate_claim_code(privkey_t issuer_key, address_t validator, uint32_t nonce, char *claimcode);
 
+/**
+ * Computes the hash that the auth sig of the claim code for 'nonce' and 'validator' signs. It
+ * covers the validator, the nonce and the claimant address.
+ */
+int get_claim_hash(address_t validator, uint32_t nonce, hash_t messagehash);
+
+/**
+ * Generates claim codes for 'count' consecutive nonces starting at 'nonce', writing each to
+ * the matching buffer in 'claimcodes'. Produces the same codes as calling generate_claim_code
+ * for each nonce, but hashes each step of the batch together and shares the modular
+ * inversions of the key derivations and signatures.
+ */
+int generate_claim_codes(privkey_t issuer_key, address_t validator, uint32_t nonce, char *const *claimcodes, size_t count);
+
 #endif
@@ -5,6 +5,9 @@
 
 #define BUTTON PC_13
 #define ISSUER_KEY_PATH "/kv/issuer_key"
+#define ISSUER_CACHE_KEY_PATH "/kv/issuer_cache"
 #define NEXT_NONCE_KEY_PATH "/kv/nonce"
+#define SEED_PRF_START_KEY_PATH "/kv/seed_prf_start"
+#define BOOT_STATS_KEY_PATH "/kv/boot_stats"
 
 #endif
\ No newline at end of file
@@ -52,13 +52,48 @@ bool ethers_privateKeyToAddress(const uint8_t *privateKey, uint8_t *address) {
     if (!success) { return false; }
 
     uint8_t hashed[32];
-    ethers_keccak256(publicKey, 64, hashed);
+    ethers_keccak256_short(publicKey, 64, hashed);
 
     memcpy(address, &hashed[12], 20);
 
     return true;
 }
 
+#define ADDRESS_BATCH_SIZE 8
+
+bool ethers_privateKeysToAddresses(const uint8_t *privateKeys, uint8_t *addresses, uint16_t count) {
+    uint8_t publicKeys[ADDRESS_BATCH_SIZE][64];
+    uint8_t hashed[ADDRESS_BATCH_SIZE][32];
+    const uint8_t *data[ADDRESS_BATCH_SIZE];
+    uint8_t *results[ADDRESS_BATCH_SIZE];
+    uint16_t lengths[ADDRESS_BATCH_SIZE];
+
+    while (count > 0) {
+        uint16_t batch = (count < ADDRESS_BATCH_SIZE) ? count : ADDRESS_BATCH_SIZE;
+
+        bool success = uECC_compute_public_keys(privateKeys, publicKeys[0], batch, uECC_secp256k1());
+        if (!success) { return false; }
+
+        for (uint16_t i = 0; i < batch; i++) {
+            data[i] = publicKeys[i];
+            lengths[i] = 64;
+            results[i] = hashed[i];
+        }
+
+        ethers_keccak256_multi(data, lengths, results, batch);
+
+        for (uint16_t i = 0; i < batch; i++) {
+            memcpy(&addresses[i * 20], &hashed[i][12], 20);
+        }
+
+        privateKeys += batch * 32;
+        addresses += batch * 20;
+        count -= batch;
+    }
+
+    return true;
+}
+
 static char getHexNibble(uint8_t value) {
     value &= 0x0f;
     if (value <= 9) { return '0' + value; }
@@ -84,7 +119,7 @@ void ethers_addressToChecksumAddress(const uint8_t *address, char *checksumAddre
 
     // Compute the hash of the address
     uint8_t hashed[32];
-    ethers_keccak256(&checksumAddress[2], 40, hashed);
+    ethers_keccak256_short((uint8_t*)&checksumAddress[2], 40, hashed);
 
     // Do the checksum
     for (uint8_t i = 0; i < 40; i += 2) {
@@ -123,6 +158,15 @@ void ethers_keccak256(const uint8_t *data, uint16_t length, uint8_t *result) {
     memset((char*)&context, 0, sizeof(SHA3_CTX));
 }
 
+void ethers_keccak256_short(const uint8_t *data, uint16_t length, uint8_t *result) {
+    keccak256_short((const unsigned char*)data, length, (unsigned char*)result);
+}
+
+void ethers_keccak256_multi(const uint8_t *const *data, const uint16_t *lengths,
+                            uint8_t *const *results, uint16_t count) {
+    keccak256_multi((const unsigned char *const *)data, lengths, (unsigned char *const *)results, count);
+}
+
 /*
 void ethers_sha256(uint8_t *data, uint16_t length, uint8_t *result) {
 
@@ -150,6 +194,48 @@ bool ethers_sign(const uint8_t *privateKey, const uint8_t *digest, uint8_t *resu
     return (success == 1);
 }
 
+bool ethers_signDigests(const uint8_t *privateKey, const uint8_t *digests, uint8_t *results,
+                        uint16_t count) {
+
+    int success = uECC_sign_batch(
+        (const uint8_t*)(privateKey),
+        (const uint8_t*)(digests),
+        32,
+        (uint8_t*)results,
+        count,
+        uECC_secp256k1()
+    );
+
+    return (success == 1);
+}
+
+bool ethers_presign(const uint8_t *privateKey, const uint8_t *seed, uint8_t *presig) {
+
+    int success = uECC_presign(
+        (const uint8_t*)(privateKey),
+        (const uint8_t*)(seed),
+        (uint8_t*)presig,
+        uECC_secp256k1()
+    );
+
+    return (success == 1);
+}
+
+bool ethers_signWithPresig(const uint8_t *privateKey, const uint8_t *digest, uint8_t *presig,
+                           uint8_t *result) {
+
+    int success = uECC_sign_with_presig(
+        (const uint8_t*)(privateKey),
+        (const uint8_t*)(digest),
+        32,
+        (uint8_t*)presig,
+        (uint8_t*)result,
+        uECC_secp256k1()
+    );
+
+    return (success == 1);
+}
+
 uint8_t ethers_getStringLength(uint8_t *value, uint8_t length) {
     // There is probably a better way to do this, but I just used the following
     // Python function:
@@ -43,6 +43,11 @@ extern "C" {
 
 bool ethers_privateKeyToAddress(const uint8_t *privateKey, uint8_t *address);
 
+// Computes the addresses of 'count' private keys, stored back to back in 'privateKeys' and
+// 'addresses'. The public keys share modular inversions (uECC_compute_public_keys) and their
+// hashes are batched through ethers_keccak256_multi.
+bool ethers_privateKeysToAddresses(const uint8_t *privateKeys, uint8_t *addresses, uint16_t count);
+
 // "0x" + (40 bytes address) + "\0"
 #define ETHERS_CHECKSUM_ADDRESS_LENGTH (2 + 40 + 1)
 
@@ -56,6 +61,17 @@ void ethers_addressToChecksumAddress(const uint8_t *address, char *checksumAddre
 
 void ethers_keccak256(const uint8_t *data, uint16_t length, uint8_t *result);
 
+// Same as ethers_keccak256; messages up to this long (one Keccak block less a byte) are hashed
+// in a single permutation without a SHA3_CTX.
+#define ETHERS_KECCAK256_SHORT_MAX_LENGTH 135
+
+void ethers_keccak256_short(const uint8_t *data, uint16_t length, uint8_t *result);
+
+// Hashes 'count' independent messages; results[i] = keccak256(data[i], lengths[i]). On x86-64
+// hosts with AVX2 or AVX-512 the messages are hashed several at a time.
+void ethers_keccak256_multi(const uint8_t *const *data, const uint16_t *lengths,
+                            uint8_t *const *results, uint16_t count);
+
 //void ethers_sha256(uint8_t *data, uint16_t length, uint8_t *result);
 
 uint8_t *ethers_debug();
@@ -64,6 +80,22 @@ uint8_t *ethers_debug();
 
 bool ethers_sign(const uint8_t *privateKey, const uint8_t *digest, uint8_t *result);
 
+// Signs 'count' digests, stored back to back in 'digests', writing the signatures back to back
+// to 'results'. Gives the same signatures as ethers_sign, with shared modular inversions.
+bool ethers_signDigests(const uint8_t *privateKey, const uint8_t *digests, uint8_t *results,
+                        uint16_t count);
+
+// r | 1/k | y parity
+#define ETHERS_PRESIGNATURE_LENGTH     65
+
+// Precomputes the nonce half of a signature (uECC_presign). The nonce is derived from
+// 'privateKey' and the 32 byte 'seed'; a seed must never be used for two different digests.
+bool ethers_presign(const uint8_t *privateKey, const uint8_t *seed, uint8_t *presig);
+
+// Signs 'digest' with a presignature from ethers_presign, which is wiped afterwards.
+bool ethers_signWithPresig(const uint8_t *privateKey, const uint8_t *digest, uint8_t *presig,
+                           uint8_t *result);
+
 
 uint8_t ethers_getStringLength(uint8_t *value, uint8_t length);
 uint8_t ethers_toString(uint8_t *amountWei, uint8_t amountWeiLength, uint8_t skipDecimal, char *result);
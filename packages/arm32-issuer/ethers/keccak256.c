@@ -32,6 +32,8 @@
 #define IS_ALIGNED_64(p) (0 == (7 & ((const char*)(p) - (const char*)0)))
 #define me64_to_le_str(to, from, length) memcpy((to), (from), (length))
 
+#if !KECCAK_UNROLLED && !KECCAK_BIT_INTERLEAVED
+
 /* constants */
 
 //const uint8_t round_constant_info[] PROGMEM = {
@@ -74,6 +76,7 @@ static uint64_t get_round_constant(uint8_t round) {
     return result;
 }
 
+#endif /* !KECCAK_UNROLLED && !KECCAK_BIT_INTERLEAVED */
 
 /* Initializing a sha3 context for given number of output bits */
 void keccak_init(SHA3_CTX *ctx) {
@@ -82,6 +85,164 @@ void keccak_init(SHA3_CTX *ctx) {
     memset(ctx, 0, sizeof(SHA3_CTX));
 }
 
+#if KECCAK_BIT_INTERLEAVED
+
+#include "keccak256-bi32.inc"
+
+#elif KECCAK_UNROLLED
+
+/* Keccak-f[1600] round constants for iota() */
+static const uint64_t round_constants[24] = {
+    I64(0x0000000000000001), I64(0x0000000000008082), I64(0x800000000000808a),
+    I64(0x8000000080008000), I64(0x000000000000808b), I64(0x0000000080000001),
+    I64(0x8000000080008081), I64(0x8000000000008009), I64(0x000000000000008a),
+    I64(0x0000000000000088), I64(0x0000000080008009), I64(0x000000008000000a),
+    I64(0x000000008000808b), I64(0x800000000000008b), I64(0x8000000000008089),
+    I64(0x8000000000008003), I64(0x8000000000008002), I64(0x8000000000000080),
+    I64(0x000000000000800a), I64(0x800000008000000a), I64(0x8000000080008081),
+    I64(0x8000000000008080), I64(0x0000000080000001), I64(0x8000000080008008)
+};
+
+/*
+ * One round from state A to state E, with the 25 lanes held in local variables named after
+ * their row (b, g, k, m, s) and column (a, e, i, o, u). theta() is folded into the D values,
+ * rho() and pi() into the choice of source lane and rotation for each B, and iota() into the
+ * first lane.
+ */
+#define KECCAK_ROUND(A, E, rc) \
+    do { \
+        Ca = A##ba ^ A##ga ^ A##ka ^ A##ma ^ A##sa; \
+        Ce = A##be ^ A##ge ^ A##ke ^ A##me ^ A##se; \
+        Ci = A##bi ^ A##gi ^ A##ki ^ A##mi ^ A##si; \
+        Co = A##bo ^ A##go ^ A##ko ^ A##mo ^ A##so; \
+        Cu = A##bu ^ A##gu ^ A##ku ^ A##mu ^ A##su; \
+        Da = Cu ^ ROTL64(Ce, 1); \
+        De = Ca ^ ROTL64(Ci, 1); \
+        Di = Ce ^ ROTL64(Co, 1); \
+        Do = Ci ^ ROTL64(Cu, 1); \
+        Du = Co ^ ROTL64(Ca, 1); \
+        Ba = A##ba ^ Da; \
+        Be = ROTL64(A##ge ^ De, 44); \
+        Bi = ROTL64(A##ki ^ Di, 43); \
+        Bo = ROTL64(A##mo ^ Do, 21); \
+        Bu = ROTL64(A##su ^ Du, 14); \
+        E##ba = Ba ^ (~Be & Bi) ^ (rc); \
+        E##be = Be ^ (~Bi & Bo); \
+        E##bi = Bi ^ (~Bo & Bu); \
+        E##bo = Bo ^ (~Bu & Ba); \
+        E##bu = Bu ^ (~Ba & Be); \
+        Ba = ROTL64(A##bo ^ Do, 28); \
+        Be = ROTL64(A##gu ^ Du, 20); \
+        Bi = ROTL64(A##ka ^ Da, 3); \
+        Bo = ROTL64(A##me ^ De, 45); \
+        Bu = ROTL64(A##si ^ Di, 61); \
+        E##ga = Ba ^ (~Be & Bi); \
+        E##ge = Be ^ (~Bi & Bo); \
+        E##gi = Bi ^ (~Bo & Bu); \
+        E##go = Bo ^ (~Bu & Ba); \
+        E##gu = Bu ^ (~Ba & Be); \
+        Ba = ROTL64(A##be ^ De, 1); \
+        Be = ROTL64(A##gi ^ Di, 6); \
+        Bi = ROTL64(A##ko ^ Do, 25); \
+        Bo = ROTL64(A##mu ^ Du, 8); \
+        Bu = ROTL64(A##sa ^ Da, 18); \
+        E##ka = Ba ^ (~Be & Bi); \
+        E##ke = Be ^ (~Bi & Bo); \
+        E##ki = Bi ^ (~Bo & Bu); \
+        E##ko = Bo ^ (~Bu & Ba); \
+        E##ku = Bu ^ (~Ba & Be); \
+        Ba = ROTL64(A##bu ^ Du, 27); \
+        Be = ROTL64(A##ga ^ Da, 36); \
+        Bi = ROTL64(A##ke ^ De, 10); \
+        Bo = ROTL64(A##mi ^ Di, 15); \
+        Bu = ROTL64(A##so ^ Do, 56); \
+        E##ma = Ba ^ (~Be & Bi); \
+        E##me = Be ^ (~Bi & Bo); \
+        E##mi = Bi ^ (~Bo & Bu); \
+        E##mo = Bo ^ (~Bu & Ba); \
+        E##mu = Bu ^ (~Ba & Be); \
+        Ba = ROTL64(A##bi ^ Di, 62); \
+        Be = ROTL64(A##go ^ Do, 55); \
+        Bi = ROTL64(A##ku ^ Du, 39); \
+        Bo = ROTL64(A##ma ^ Da, 41); \
+        Bu = ROTL64(A##se ^ De, 2); \
+        E##sa = Ba ^ (~Be & Bi); \
+        E##se = Be ^ (~Bi & Bo); \
+        E##si = Bi ^ (~Bo & Bu); \
+        E##so = Bo ^ (~Bu & Ba); \
+        E##su = Bu ^ (~Ba & Be); \
+    } while (0)
+
+static void sha3_permutation(uint64_t *state) {
+    uint64_t Aba, Abe, Abi, Abo, Abu, Aga, Age, Agi, Ago, Agu, Aka, Ake, Aki,
+             Ako, Aku, Ama, Ame, Ami, Amo, Amu, Asa, Ase, Asi, Aso, Asu;
+    uint64_t Eba, Ebe, Ebi, Ebo, Ebu, Ega, Ege, Egi, Ego, Egu, Eka, Eke, Eki,
+             Eko, Eku, Ema, Eme, Emi, Emo, Emu, Esa, Ese, Esi, Eso, Esu;
+    uint64_t Ba, Be, Bi, Bo, Bu;
+    uint64_t Ca, Ce, Ci, Co, Cu;
+    uint64_t Da, De, Di, Do, Du;
+
+    Aba = state[0];
+    Abe = state[1];
+    Abi = state[2];
+    Abo = state[3];
+    Abu = state[4];
+    Aga = state[5];
+    Age = state[6];
+    Agi = state[7];
+    Ago = state[8];
+    Agu = state[9];
+    Aka = state[10];
+    Ake = state[11];
+    Aki = state[12];
+    Ako = state[13];
+    Aku = state[14];
+    Ama = state[15];
+    Ame = state[16];
+    Ami = state[17];
+    Amo = state[18];
+    Amu = state[19];
+    Asa = state[20];
+    Ase = state[21];
+    Asi = state[22];
+    Aso = state[23];
+    Asu = state[24];
+
+    /* Two rounds per iteration, so the lanes swap between A and E without copying */
+    for (uint8_t round = 0; round < 24; round += 2) {
+        KECCAK_ROUND(A, E, round_constants[round]);
+        KECCAK_ROUND(E, A, round_constants[round + 1]);
+    }
+
+    state[0] = Aba;
+    state[1] = Abe;
+    state[2] = Abi;
+    state[3] = Abo;
+    state[4] = Abu;
+    state[5] = Aga;
+    state[6] = Age;
+    state[7] = Agi;
+    state[8] = Ago;
+    state[9] = Agu;
+    state[10] = Aka;
+    state[11] = Ake;
+    state[12] = Aki;
+    state[13] = Ako;
+    state[14] = Aku;
+    state[15] = Ama;
+    state[16] = Ame;
+    state[17] = Ami;
+    state[18] = Amo;
+    state[19] = Amu;
+    state[20] = Asa;
+    state[21] = Ase;
+    state[22] = Asi;
+    state[23] = Aso;
+    state[24] = Asu;
+}
+
+#else /* KECCAK_BIT_INTERLEAVED, KECCAK_UNROLLED */
+
 /* Keccak theta() transformation */
 static void keccak_theta(uint64_t *A) {
     uint64_t C[5], D[5];
@@ -151,6 +312,8 @@ static void sha3_permutation(uint64_t *state) {
     }
 }
 
+#endif /* KECCAK_BIT_INTERLEAVED, KECCAK_UNROLLED */
+
 /**
  * The core transformation. Process the specified block of data.
  *
@@ -160,7 +323,11 @@ static void sha3_permutation(uint64_t *state) {
  */
 static void sha3_process_block(uint64_t hash[25], const uint64_t *block) {
     for (uint8_t i = 0; i < 17; i++) {
+#if KECCAK_BIT_INTERLEAVED
+        hash[i] ^= interleave_lane(le2me_64(block[i]));
+#else
         hash[i] ^= le2me_64(block[i]);
+#endif
     }
 
     /* make a permutation of the hash */
@@ -239,6 +406,105 @@ void keccak_final(SHA3_CTX *ctx, unsigned char* result)
 //    }
 
     if (result) {
+#if KECCAK_BIT_INTERLEAVED
+        for (uint8_t i = 0; i < digest_length / 8; i++) {
+            ctx->hash[i] = deinterleave_lane(ctx->hash[i]);
+        }
+#endif
          me64_to_le_str(result, ctx->hash, digest_length);
     }
 }
+
+/**
+ * Calculate the hash of a message, fastest for one shorter than a block.
+ * Such a message is absorbed straight into a state on the stack and padded in place, so this
+ * needs neither a SHA3_CTX nor its message buffer, and runs a single permutation. Longer ones
+ * go through keccak_init/keccak_update/keccak_final.
+ *
+ * @param msg the message
+ * @param size length of the message
+ * @param result calculated hash in binary form
+ */
+void keccak256_short(const unsigned char *msg, uint16_t size, unsigned char *result)
+{
+    if (size >= BLOCK_SIZE) {
+        SHA3_CTX ctx;
+        keccak_init(&ctx);
+        keccak_update(&ctx, msg, size);
+        keccak_final(&ctx, result);
+        memset(&ctx, 0, sizeof(ctx));
+        return;
+    }
+
+    uint64_t state[sha3_max_permutation_size];
+
+    memset(state, 0, sizeof(state));
+    memcpy(state, msg, size);
+    ((char*)state)[size] |= 0x01;
+    ((char*)state)[BLOCK_SIZE - 1] |= 0x80;
+
+#if KECCAK_BIT_INTERLEAVED
+    for (uint8_t i = 0; i < BLOCK_SIZE / 8; i++) {
+        state[i] = interleave_lane(state[i]);
+    }
+#endif
+
+    sha3_permutation(state);
+
+#if KECCAK_BIT_INTERLEAVED
+    for (uint8_t i = 0; i < 4; i++) {
+        state[i] = deinterleave_lane(state[i]);
+    }
+#endif
+
+    me64_to_le_str(result, state, 32);
+
+    // Clear out the contents of what we hashed (in case it was secret)
+    memset(state, 0, sizeof(state));
+}
+
+#if KECCAK_MULTI_X86
+#include "keccak256-x86.inc"
+#endif
+
+/**
+ * Calculate the hashes of several independent messages.
+ * The results are the same as hashing each message on its own, but on x86-64 hosts with
+ * AVX2 or AVX-512 up to 8 messages are processed in parallel.
+ *
+ * @param msgs the messages
+ * @param sizes the length of each message
+ * @param results receives the 32-byte hash of each message
+ * @param count the number of messages
+ */
+void keccak256_multi(const unsigned char *const *msgs,
+                     const uint16_t *sizes,
+                     unsigned char *const *results,
+                     uint16_t count)
+{
+#if KECCAK_MULTI_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        for (; count >= 8; count -= 8, msgs += 8, sizes += 8, results += 8) {
+            keccak256_x8(msgs, sizes, results);
+        }
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        for (; count >= 4; count -= 4, msgs += 4, sizes += 4, results += 4) {
+            keccak256_x4(msgs, sizes, results);
+        }
+    }
+#endif
+
+    for (; count > 0; count--, msgs++, sizes++, results++) {
+        SHA3_CTX ctx;
+        if (*sizes < BLOCK_SIZE) {
+            keccak256_short(*msgs, *sizes, *results);
+            continue;
+        }
+        keccak_init(&ctx);
+        keccak_update(&ctx, *msgs, *sizes);
+        keccak_final(&ctx, *results);
+        memset(&ctx, 0, sizeof(SHA3_CTX));
+    }
+}
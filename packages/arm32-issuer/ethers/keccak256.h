@@ -22,6 +22,37 @@
 
 #include <stdint.h>
 
+/* KECCAK_UNROLLED - If enabled (defined as nonzero), the permutation is built with its round
+   constants as literals and its round body fully unrolled over lanes in local variables. This
+   is several times faster than the compact table-driven version, at the cost of a few KB of
+   code. */
+#ifndef KECCAK_UNROLLED
+    #define KECCAK_UNROLLED 1
+#endif
+
+/* KECCAK_BIT_INTERLEAVED - If enabled (defined as nonzero), the permutation is built from 32-bit
+   words with the bit-interleaving and lane complementing techniques, which avoids 64-bit
+   rotations. This is the faster choice on 32-bit ARM and takes precedence over
+   KECCAK_UNROLLED. */
+#ifndef KECCAK_BIT_INTERLEAVED
+    #if defined(__arm__) || defined(__thumb__)
+        #define KECCAK_BIT_INTERLEAVED 1
+    #else
+        #define KECCAK_BIT_INTERLEAVED 0
+    #endif
+#endif
+
+/* KECCAK_MULTI_X86 - If enabled (defined as nonzero), keccak256_multi() hashes 8 or 4 messages
+   at a time with AVX-512 or AVX2 when CPUID reports them. Only available for x86-64 builds with
+   GCC or Clang; otherwise keccak256_multi() hashes the messages one at a time. */
+#ifndef KECCAK_MULTI_X86
+    #if defined(__x86_64__) && defined(__GNUC__)
+        #define KECCAK_MULTI_X86 1
+    #else
+        #define KECCAK_MULTI_X86 0
+    #endif
+#endif
+
 #define sha3_max_permutation_size 25
 #define sha3_max_rate_in_qwords 24
 
@@ -45,6 +76,11 @@ extern "C" {
 void keccak_init(SHA3_CTX *ctx);
 void keccak_update(SHA3_CTX *ctx, const unsigned char *msg, uint16_t size);
 void keccak_final(SHA3_CTX *ctx, unsigned char* result);
+void keccak256_short(const unsigned char *msg, uint16_t size, unsigned char *result);
+void keccak256_multi(const unsigned char *const *msgs,
+                     const uint16_t *sizes,
+                     unsigned char *const *results,
+                     uint16_t count);
 
 
 #ifdef __cplusplus
@@ -35,6 +35,14 @@
     #endif
 #endif
 
+#ifndef uECC_X86_64_USE_MULX
+    #if (uECC_PLATFORM == uECC_x86_64) && defined(__GNUC__)
+        #define uECC_X86_64_USE_MULX 1
+    #else
+        #define uECC_X86_64_USE_MULX 0
+    #endif
+#endif
+
 #ifndef uECC_WORD_SIZE
     #if uECC_PLATFORM == uECC_avr
         #define uECC_WORD_SIZE 1
@@ -63,6 +71,11 @@
     #define uECC_WORD_SIZE 4
 #endif
 
+/* The 10x26 lazy field of field-10x26.inc pays off where the native word is 32 bits. */
+#ifndef uECC_SECP256K1_LAZY_FIELD
+    #define uECC_SECP256K1_LAZY_FIELD (uECC_WORD_SIZE == 4)
+#endif
+
 #if defined(__SIZEOF_INT128__) || ((__clang_major__ * 100 + __clang_minor__) >= 302)
     #define SUPPORTS_INT128 1
 #else
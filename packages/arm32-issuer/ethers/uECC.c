@@ -15,6 +15,12 @@
     #define uECC_RNG_MAX_TRIES 64
 #endif
 
+/* Number of points or nonces that share one modular inversion in the batch functions. Each
+   one costs about 5 * uECC_MAX_WORDS words of stack. */
+#ifndef uECC_BATCH_SIZE
+    #define uECC_BATCH_SIZE 8
+#endif
+
 #if uECC_ENABLE_VLI_API
     #define uECC_VLI_API
 #else
@@ -163,6 +169,36 @@ struct uECC_Curve_t {
 #if (uECC_OPTIMIZATION_LEVEL > 0)
     void (*mmod_fast)(uECC_word_t *result, uECC_word_t *product);
 #endif
+#if uECC_FIXED_BASE_COMB
+    /* Computes (X : Y : Z) = scalar * G in homogeneous projective coordinates. Null for curves
+       without a fixed-base table. */
+    void (*mult_G)(uECC_word_t *X,
+                   uECC_word_t *Y,
+                   uECC_word_t *Z,
+                   const uECC_word_t *scalar,
+                   uECC_Curve curve);
+#endif
+#if uECC_GLV_ENDOMORPHISM
+    /* Computes (X : Y : Z) = scalar * point in homogeneous projective coordinates. initial_Z
+       may be 0. X and Y may overlap point. Null for curves without an endomorphism. */
+    void (*mult_point)(uECC_word_t *X,
+                       uECC_word_t *Y,
+                       uECC_word_t *Z,
+                       const uECC_word_t *point,
+                       const uECC_word_t *scalar,
+                       const uECC_word_t *initial_Z,
+                       uECC_Curve curve);
+    /* Computes result = u1 * G + u2 * point. */
+    void (*double_mult)(uECC_word_t *result,
+                        const uECC_word_t *u1,
+                        const uECC_word_t *point,
+                        const uECC_word_t *u2,
+                        uECC_Curve curve);
+#endif
+#if (uECC_OPTIMIZATION_LEVEL > 0)
+    /* Computes result = product % n. Null for curves without a fast reduction modulo n. */
+    void (*mmod_n_fast)(uECC_word_t *result, uECC_word_t *product);
+#endif
 };
 
 #if uECC_VLI_NATIVE_LITTLE_ENDIAN
@@ -189,6 +225,10 @@ static cmpresult_t uECC_vli_cmp_unsafe(const uECC_word_t *left,
     #include "asm_avr.inc"
 #endif
 
+#if (uECC_PLATFORM == uECC_x86_64)
+    #include "asm_x86_64.inc"
+#endif
+
 #if default_RNG_defined
 static uECC_RNG_Function g_rng_function = &default_RNG;
 #else
@@ -372,7 +412,7 @@ uECC_VLI_API uECC_word_t uECC_vli_sub(uECC_word_t *result,
 #endif /* !asm_sub */
 
 #if !asm_mult || (uECC_SQUARE_FUNC && !asm_square) || \
-    (uECC_SUPPORTS_secp256k1 && (uECC_OPTIMIZATION_LEVEL > 0) && \
+    (uECC_SUPPORTS_secp256k1 && (uECC_OPTIMIZATION_LEVEL > 0) && !asm_mmod_fast_secp256k1 && \
         ((uECC_WORD_SIZE == 1) || (uECC_WORD_SIZE == 8)))
 static void muladd(uECC_word_t a,
                    uECC_word_t b,
@@ -627,6 +667,13 @@ uECC_VLI_API void uECC_vli_modMult_fast(uECC_word_t *result,
                                         const uECC_word_t *right,
                                         uECC_Curve curve) {
     uECC_word_t product[2 * uECC_MAX_WORDS];
+#if asm_modMult_fast_secp256k1
+    /* secp256k1 is the only 8-word curve when the fused routine is built. */
+    if (curve->num_words == 8) {
+        vli_modMult_fast_secp256k1(result, left, right);
+        return;
+    }
+#endif
     uECC_vli_mult(product, left, right, curve->num_words);
 #if (uECC_OPTIMIZATION_LEVEL > 0)
     curve->mmod_fast(result, product);
@@ -653,6 +700,12 @@ uECC_VLI_API void uECC_vli_modSquare_fast(uECC_word_t *result,
                                           const uECC_word_t *left,
                                           uECC_Curve curve) {
     uECC_word_t product[2 * uECC_MAX_WORDS];
+#if asm_modMult_fast_secp256k1
+    if (curve->num_words == 8) {
+        vli_modSquare_fast_secp256k1(result, left);
+        return;
+    }
+#endif
     uECC_vli_square(product, left, curve->num_words);
 #if (uECC_OPTIMIZATION_LEVEL > 0)
     curve->mmod_fast(result, product);
@@ -680,6 +733,21 @@ uECC_VLI_API void uECC_vli_modSquare_fast(uECC_word_t *result,
 
 #endif /* uECC_SQUARE_FUNC */
 
+#if uECC_SAFEGCD_INVERSE
+
+#include "modinv-safegcd.inc"
+
+/* Computes result = (1 / input) % mod. All VLIs are the same size. mod must be odd.
+   Runs in constant time; see modinv-safegcd.inc. */
+uECC_VLI_API void uECC_vli_modInv(uECC_word_t *result,
+                                  const uECC_word_t *input,
+                                  const uECC_word_t *mod,
+                                  wordcount_t num_words) {
+    vli_modInv_safegcd(result, input, mod, num_words);
+}
+
+#else
+
 #define EVEN(vli) (!(vli[0] & 1))
 static void vli_modInv_update(uECC_word_t *uv,
                               const uECC_word_t *mod,
@@ -741,6 +809,59 @@ uECC_VLI_API void uECC_vli_modInv(uECC_word_t *result,
     uECC_vli_set(result, u, num_words);
 }
 
+#endif /* uECC_SAFEGCD_INVERSE */
+
+/* Computes result = (left * right) % curve->n. */
+static void vli_modMult_n(uECC_word_t *result,
+                          const uECC_word_t *left,
+                          const uECC_word_t *right,
+                          uECC_Curve curve) {
+#if (uECC_OPTIMIZATION_LEVEL > 0)
+    if (curve->mmod_n_fast) {
+        uECC_word_t product[2 * uECC_MAX_WORDS];
+        uECC_vli_mult(product, left, right, curve->num_words);
+        curve->mmod_n_fast(result, product);
+        return;
+    }
+#endif
+    uECC_vli_modMult(result, left, right, curve->n, BITS_TO_WORDS(curve->num_n_bits));
+}
+
+/* Replaces each of the count values (curve->num_words words each) with its inverse modulo mod,
+   using one uECC_vli_modInv() and 3 * (count - 1) multiplications (Montgomery's trick).
+   mod_mult must multiply modulo mod. scratch must have room for count values. The values
+   must be nonzero; if one is zero, all results are zero. */
+static void vli_modInv_batch(uECC_word_t *values,
+                             uECC_word_t *scratch,
+                             unsigned count,
+                             const uECC_word_t *mod,
+                             void (*mod_mult)(uECC_word_t *result,
+                                              const uECC_word_t *left,
+                                              const uECC_word_t *right,
+                                              uECC_Curve curve),
+                             uECC_Curve curve) {
+    uECC_word_t inv[uECC_MAX_WORDS];
+    uECC_word_t tmp[uECC_MAX_WORDS];
+    wordcount_t num_words = curve->num_words;
+    unsigned i;
+
+    /* scratch[i] = values[0] * ... * values[i] */
+    uECC_vli_set(scratch, values, num_words);
+    for (i = 1; i < count; ++i) {
+        mod_mult(scratch + i * num_words, scratch + (i - 1) * num_words,
+                 values + i * num_words, curve);
+    }
+
+    uECC_vli_modInv(inv, scratch + (count - 1) * num_words, mod, num_words);
+
+    for (i = count - 1; i > 0; --i) {
+        mod_mult(tmp, inv, scratch + (i - 1) * num_words, curve);  /* 1 / values[i] */
+        mod_mult(inv, inv, values + i * num_words, curve); /* 1 / (values[0] ... values[i - 1]) */
+        uECC_vli_set(values + i * num_words, tmp, num_words);
+    }
+    uECC_vli_set(values, inv, num_words);
+}
+
 /* ------ Point operations ------ */
 
 #include "curve-specific.inc"
@@ -861,13 +982,16 @@ static void XYcZ_addC(uECC_word_t * X1,
     uECC_vli_set(X1, t7, num_words);
 }
 
-/* result may overlap point. */
-static void EccPoint_mult(uECC_word_t * result,
-                          const uECC_word_t * point,
-                          const uECC_word_t * scalar,
-                          const uECC_word_t * initial_Z,
-                          bitcount_t num_bits,
-                          uECC_Curve curve) {
+/* Computes scalar * point without the final inversion: result receives (X, Y) in Jacobian
+   coordinates for the returned Z, i.e. the affine point is (X / Z^2, Y / Z^3).
+   result may overlap point. */
+static void EccPoint_mult_jacobian(uECC_word_t * result,
+                                   uECC_word_t * Z,
+                                   const uECC_word_t * point,
+                                   const uECC_word_t * scalar,
+                                   const uECC_word_t * initial_Z,
+                                   bitcount_t num_bits,
+                                   uECC_Curve curve) {
     /* R0 and R1 */
     uECC_word_t Rx[2][uECC_MAX_WORDS];
     uECC_word_t Ry[2][uECC_MAX_WORDS];
@@ -890,15 +1014,11 @@ static void EccPoint_mult(uECC_word_t * result,
     nb = !uECC_vli_testBit(scalar, 0);
     XYcZ_addC(Rx[1 - nb], Ry[1 - nb], Rx[nb], Ry[nb], curve);
 
-    /* Find final 1/Z value. */
-    uECC_vli_modSub(z, Rx[1], Rx[0], curve->p, num_words); /* X1 - X0 */
-    uECC_vli_modMult_fast(z, z, Ry[1 - nb], curve);               /* Yb * (X1 - X0) */
-    uECC_vli_modMult_fast(z, z, point, curve);                    /* xP * Yb * (X1 - X0) */
-    uECC_vli_modInv(z, z, curve->p, num_words);            /* 1 / (xP * Yb * (X1 - X0)) */
-    /* yP / (xP * Yb * (X1 - X0)) */
-    uECC_vli_modMult_fast(z, z, point + num_words, curve);
-    uECC_vli_modMult_fast(z, z, Rx[1 - nb], curve); /* Xb * yP / (xP * Yb * (X1 - X0)) */
-    /* End 1/Z calculation */
+    /* The final 1/Z value is (Xb * yP) / (xP * Yb * (X1 - X0)). */
+    uECC_vli_modSub(Z, Rx[1], Rx[0], curve->p, num_words); /* X1 - X0 */
+    uECC_vli_modMult_fast(Z, Z, Ry[1 - nb], curve);               /* Yb * (X1 - X0) */
+    uECC_vli_modMult_fast(Z, Z, point, curve);                    /* xP * Yb * (X1 - X0) */
+    uECC_vli_modMult_fast(z, point + num_words, Rx[1 - nb], curve); /* Xb * yP */
 
     XYcZ_add(Rx[nb], Ry[nb], Rx[1 - nb], Ry[1 - nb], curve);
     apply_z(Rx[0], Ry[0], z, curve);
@@ -907,6 +1027,20 @@ static void EccPoint_mult(uECC_word_t * result,
     uECC_vli_set(result + num_words, Ry[0], num_words);
 }
 
+/* result may overlap point. */
+static void EccPoint_mult(uECC_word_t * result,
+                          const uECC_word_t * point,
+                          const uECC_word_t * scalar,
+                          const uECC_word_t * initial_Z,
+                          bitcount_t num_bits,
+                          uECC_Curve curve) {
+    uECC_word_t z[uECC_MAX_WORDS];
+
+    EccPoint_mult_jacobian(result, z, point, scalar, initial_Z, num_bits, curve);
+    uECC_vli_modInv(z, z, curve->p, curve->num_words);
+    apply_z(result, result + curve->num_words, z, curve);
+}
+
 static uECC_word_t regularize_k(const uECC_word_t * const k,
                                 uECC_word_t *k0,
                                 uECC_word_t *k1,
@@ -920,19 +1054,77 @@ static uECC_word_t regularize_k(const uECC_word_t * const k,
     return carry;
 }
 
-static uECC_word_t EccPoint_compute_public_key(uECC_word_t *result,
-                                               uECC_word_t *private_key,
-                                               uECC_Curve curve) {
+/* Converts count points to affine coordinates in place, sharing a single inversion. Each point
+   in points has the matching denominator in Z; the points are Jacobian (x = X / Z^2,
+   y = Y / Z^3) if jacobian is nonzero, homogeneous projective (x = X / Z, y = Y / Z)
+   otherwise. Z is overwritten. scratch must have room for count values. */
+static void EccPoint_normalize_batch(uECC_word_t *points,
+                                     uECC_word_t *Z,
+                                     uECC_word_t *scratch,
+                                     unsigned count,
+                                     uECC_word_t jacobian,
+                                     uECC_Curve curve) {
+    wordcount_t num_words = curve->num_words;
+    unsigned i;
+
+    vli_modInv_batch(Z, scratch, count, curve->p, &uECC_vli_modMult_fast, curve);
+    for (i = 0; i < count; ++i) {
+        uECC_word_t *X = points + 2 * i * num_words;
+        uECC_word_t *Y = X + num_words;
+        if (jacobian) {
+            apply_z(X, Y, Z + i * num_words, curve);
+        } else {
+            uECC_vli_modMult_fast(X, X, Z + i * num_words, curve);
+            uECC_vli_modMult_fast(Y, Y, Z + i * num_words, curve);
+        }
+    }
+}
+
+/* Computes scalar * G, for 0 < scalar < n, without the final inversion. result receives (X, Y)
+   and Z the denominator, to be passed to EccPoint_normalize_batch(). Returns 1 if the result
+   is in Jacobian coordinates, 0 if it is homogeneous projective. */
+static uECC_word_t EccPoint_mult_G_projective(uECC_word_t *result,
+                                              uECC_word_t *Z,
+                                              const uECC_word_t *scalar,
+                                              uECC_Curve curve) {
     uECC_word_t tmp1[uECC_MAX_WORDS];
     uECC_word_t tmp2[uECC_MAX_WORDS];
     uECC_word_t *p2[2] = {tmp1, tmp2};
     uECC_word_t carry;
 
-    /* Regularize the bitcount for the private key so that attackers cannot use a side channel
+#if uECC_FIXED_BASE_COMB
+    if (curve->mult_G) {
+        curve->mult_G(result, result + curve->num_words, Z, scalar, curve);
+        return 0;
+    }
+#endif
+#if uECC_GLV_ENDOMORPHISM
+    if (curve->mult_point) {
+        curve->mult_point(result, result + curve->num_words, Z, curve->G, scalar, 0, curve);
+        return 0;
+    }
+#endif
+
+    /* Regularize the bitcount for the scalar so that attackers cannot use a side channel
        attack to learn the number of leading zeros. */
-    carry = regularize_k(private_key, tmp1, tmp2, curve);
+    carry = regularize_k(scalar, tmp1, tmp2, curve);
 
-    EccPoint_mult(result, curve->G, p2[!carry], 0, curve->num_n_bits + 1, curve);
+    EccPoint_mult_jacobian(result, Z, curve->G, p2[!carry], 0, curve->num_n_bits + 1, curve);
+    return 1;
+}
+
+/* Computes result = scalar * G, for 0 < scalar < n. */
+static void EccPoint_mult_G(uECC_word_t *result, const uECC_word_t *scalar, uECC_Curve curve) {
+    uECC_word_t Z[uECC_MAX_WORDS];
+    uECC_word_t scratch[uECC_MAX_WORDS];
+    uECC_word_t jacobian = EccPoint_mult_G_projective(result, Z, scalar, curve);
+    EccPoint_normalize_batch(result, Z, scratch, 1, jacobian, curve);
+}
+
+static uECC_word_t EccPoint_compute_public_key(uECC_word_t *result,
+                                               uECC_word_t *private_key,
+                                               uECC_Curve curve) {
+    EccPoint_mult_G(result, private_key, curve);
 
     if (EccPoint_isZero(result, curve)) {
         return 0;
@@ -1062,20 +1254,35 @@ int uECC_shared_secret(const uint8_t *public_key,
     uECC_vli_bytesToNative(_public + num_words, public_key + num_bytes, num_bytes);
 #endif
 
-    /* Regularize the bitcount for the private key so that attackers cannot use a side channel
-       attack to learn the number of leading zeros. */
-    carry = regularize_k(_private, _private, tmp, curve);
-
-    /* If an RNG function was specified, try to get a random initial Z value to improve
-       protection against side-channel attacks. */
-    if (g_rng_function) {
-        if (!uECC_generate_random_int(p2[carry], curve->p, num_words)) {
-            return 0;
+#if uECC_GLV_ENDOMORPHISM
+    if (curve->mult_point) {
+        if (g_rng_function) {
+            if (!uECC_generate_random_int(tmp, curve->p, num_words)) {
+                return 0;
+            }
+            initial_Z = tmp;
+        }
+        uECC_word_t Z[uECC_MAX_WORDS];
+        curve->mult_point(_public, _public + num_words, Z, _public, _private, initial_Z, curve);
+        EccPoint_normalize_batch(_public, Z, tmp, 1, 0, curve);
+    } else
+#endif
+    {
+        /* Regularize the bitcount for the private key so that attackers cannot use a side
+           channel attack to learn the number of leading zeros. */
+        carry = regularize_k(_private, _private, tmp, curve);
+
+        /* If an RNG function was specified, try to get a random initial Z value to improve
+           protection against side-channel attacks. */
+        if (g_rng_function) {
+            if (!uECC_generate_random_int(p2[carry], curve->p, num_words)) {
+                return 0;
+            }
+            initial_Z = p2[carry];
         }
-        initial_Z = p2[carry];
-    }
 
-    EccPoint_mult(_public, _public, p2[!carry], initial_Z, curve->num_n_bits + 1, curve);
+        EccPoint_mult(_public, _public, p2[!carry], initial_Z, curve->num_n_bits + 1, curve);
+    }
 #if uECC_VLI_NATIVE_LITTLE_ENDIAN
     bcopy((uint8_t *) secret, (uint8_t *) _public, num_bytes);
 #else
@@ -1196,6 +1403,68 @@ int uECC_compute_public_key(const uint8_t *private_key, uint8_t *public_key, uEC
     return 1;
 }
 
+int uECC_compute_public_keys(const uint8_t *private_keys,
+                             uint8_t *public_keys,
+                             unsigned count,
+                             uECC_Curve curve) {
+    uECC_word_t _private[uECC_MAX_WORDS];
+    uECC_word_t _public[uECC_BATCH_SIZE * uECC_MAX_WORDS * 2];
+    uECC_word_t Z[uECC_BATCH_SIZE * uECC_MAX_WORDS];
+    uECC_word_t scratch[uECC_BATCH_SIZE * uECC_MAX_WORDS];
+    uECC_word_t jacobian = 0;
+    wordcount_t num_words = curve->num_words;
+    wordcount_t num_bytes = curve->num_bytes;
+    wordcount_t num_n_words = BITS_TO_WORDS(curve->num_n_bits);
+    wordcount_t num_n_bytes = BITS_TO_BYTES(curve->num_n_bits);
+    unsigned batch;
+    unsigned i;
+
+    while (count > 0) {
+        batch = (count < uECC_BATCH_SIZE) ? count : uECC_BATCH_SIZE;
+
+        for (i = 0; i < batch; ++i) {
+#if uECC_VLI_NATIVE_LITTLE_ENDIAN
+            uECC_vli_clear(_private, num_n_words);
+            bcopy((uint8_t *) _private, private_keys + i * num_n_bytes, num_n_bytes);
+#else
+            uECC_vli_bytesToNative(_private, private_keys + i * num_n_bytes, num_n_bytes);
+#endif
+
+            /* Make sure the private key is in the range [1, n-1]. */
+            if (uECC_vli_isZero(_private, num_n_words) ||
+                    uECC_vli_cmp(curve->n, _private, num_n_words) != 1) {
+                return 0;
+            }
+
+            jacobian = EccPoint_mult_G_projective(
+                _public + 2 * i * num_words, Z + i * num_words, _private, curve);
+        }
+
+        EccPoint_normalize_batch(_public, Z, scratch, batch, jacobian, curve);
+
+        for (i = 0; i < batch; ++i) {
+            uECC_word_t *point = _public + 2 * i * num_words;
+            uint8_t *public_key = public_keys + 2 * i * num_bytes;
+            if (EccPoint_isZero(point, curve)) {
+                return 0;
+            }
+#if uECC_VLI_NATIVE_LITTLE_ENDIAN
+            bcopy(public_key, (uint8_t *) point, num_bytes * 2);
+#else
+            uECC_vli_nativeToBytes(public_key, num_bytes, point);
+            uECC_vli_nativeToBytes(public_key + num_bytes, num_bytes, point + num_words);
+#endif
+        }
+
+        private_keys += batch * num_n_bytes;
+        public_keys += batch * 2 * num_bytes;
+        count -= batch;
+    }
+
+    uECC_vli_clear(_private, num_n_words);
+    return 1;
+}
+
 
 /* -------- ECDSA code -------- */
 
@@ -1237,53 +1506,26 @@ static void bits2int(uECC_word_t *native,
     }
 }
 
-static int uECC_sign_with_k(const uint8_t *private_key,
-                            const uint8_t *message_hash,
-                            unsigned hash_size,
-                            uECC_word_t *k,
-                            uint8_t *signature,
-                            uECC_Curve curve) {
+/* Finishes a signature from p = k * G (affine) and k_inv = 1 / k. */
+static int sign_with_inverse_k(const uint8_t *private_key,
+                               const uint8_t *message_hash,
+                               unsigned hash_size,
+                               const uECC_word_t *k_inv,
+                               const uECC_word_t *p,
+                               uint8_t *signature,
+                               uECC_Curve curve) {
 
     uECC_word_t tmp[uECC_MAX_WORDS];
     uECC_word_t s[uECC_MAX_WORDS];
-    uECC_word_t *k2[2] = {tmp, s};
-#if uECC_VLI_NATIVE_LITTLE_ENDIAN
-    uECC_word_t *p = (uECC_word_t *)signature;
-#else
-    uECC_word_t p[uECC_MAX_WORDS * 2];
-#endif
-    uECC_word_t carry;
     wordcount_t num_words = curve->num_words;
     wordcount_t num_n_words = BITS_TO_WORDS(curve->num_n_bits);
-    bitcount_t num_n_bits = curve->num_n_bits;
-
-    /* Make sure 0 < k < curve_n */
-    if (uECC_vli_isZero(k, num_words) || uECC_vli_cmp(curve->n, k, num_n_words) != 1) {
-        return 0;
-    }
+    uECC_word_t odd_y = p[num_words] & 0x01;
 
-    carry = regularize_k(k, tmp, s, curve);
-    EccPoint_mult(p, curve->G, k2[!carry], 0, num_n_bits + 1, curve);
-    if (uECC_vli_isZero(p, num_words)) {
-        return 0;
-    }
-    /* If an RNG function was specified, get a random number
-       to prevent side channel analysis of k. */
-
-    if (!g_rng_function) {
-        uECC_vli_clear(tmp, num_n_words);
-        tmp[0] = 1;
-    } else if (!uECC_generate_random_int(tmp, curve->n, num_n_words)) {
-        return 0;
+#if uECC_VLI_NATIVE_LITTLE_ENDIAN
+    if ((const uint8_t *)p != signature) {
+        bcopy(signature, (const uint8_t *) p, curve->num_bytes); /* store r */
     }
-
-    /* Prevent side channel analysis of uECC_vli_modInv() to determine
-       bits of k / the private key by premultiplying by a random number */
-    uECC_vli_modMult(k, k, tmp, curve->n, num_n_words); /* k' = rand * k */
-    uECC_vli_modInv(k, k, curve->n, num_n_words);       /* k = 1 / k' */
-    uECC_vli_modMult(k, k, tmp, curve->n, num_n_words); /* k = 1 / k */
-
-#if uECC_VLI_NATIVE_LITTLE_ENDIAN == 0
+#else
     uECC_vli_nativeToBytes(signature, curve->num_bytes, p); /* store r */
 #endif
 
@@ -1295,11 +1537,11 @@ static int uECC_sign_with_k(const uint8_t *private_key,
 
     s[num_n_words - 1] = 0;
     uECC_vli_set(s, p, num_words);
-    uECC_vli_modMult(s, tmp, s, curve->n, num_n_words); /* s = r*d */
+    vli_modMult_n(s, tmp, s, curve); /* s = r*d */
 
     bits2int(tmp, message_hash, hash_size, curve);
     uECC_vli_modAdd(s, tmp, s, curve->n, num_n_words); /* s = e + r*d */
-    uECC_vli_modMult(s, s, k, curve->n, num_n_words);  /* s = (e + r*d) / k */
+    vli_modMult_n(s, s, k_inv, curve);  /* s = (e + r*d) / k */
     if (uECC_vli_numBits(s, num_n_words) > (bitcount_t)curve->num_bytes * 8) {
         return 0;
     }
@@ -1318,12 +1560,64 @@ static int uECC_sign_with_k(const uint8_t *private_key,
 #endif    
 
     // nickjohnson: Extract v and set it as the MSB of s, per EIP 2098
-    if(p[num_words] & 0x01) {
+    if(odd_y) {
         signature[curve->num_bytes] |= 0x80;
     }
 
     return 1;
 }
+
+static int uECC_sign_with_k(const uint8_t *private_key,
+                            const uint8_t *message_hash,
+                            unsigned hash_size,
+                            uECC_word_t *k,
+                            uint8_t *signature,
+                            uECC_Curve curve) {
+
+#if !uECC_SAFEGCD_INVERSE
+    uECC_word_t tmp[uECC_MAX_WORDS];
+#endif
+#if uECC_VLI_NATIVE_LITTLE_ENDIAN
+    uECC_word_t *p = (uECC_word_t *)signature;
+#else
+    uECC_word_t p[uECC_MAX_WORDS * 2];
+#endif
+    wordcount_t num_words = curve->num_words;
+    wordcount_t num_n_words = BITS_TO_WORDS(curve->num_n_bits);
+
+    /* Make sure 0 < k < curve_n */
+    if (uECC_vli_isZero(k, num_words) || uECC_vli_cmp(curve->n, k, num_n_words) != 1) {
+        return 0;
+    }
+
+    EccPoint_mult_G(p, k, curve);
+    if (uECC_vli_isZero(p, num_words)) {
+        return 0;
+    }
+
+#if uECC_SAFEGCD_INVERSE
+    /* The inversion runs in constant time, so k needs no blinding. */
+    uECC_vli_modInv(k, k, curve->n, num_n_words);       /* k = 1 / k */
+#else
+    /* If an RNG function was specified, get a random number
+       to prevent side channel analysis of k. */
+
+    if (!g_rng_function) {
+        uECC_vli_clear(tmp, num_n_words);
+        tmp[0] = 1;
+    } else if (!uECC_generate_random_int(tmp, curve->n, num_n_words)) {
+        return 0;
+    }
+
+    /* Prevent side channel analysis of uECC_vli_modInv() to determine
+       bits of k / the private key by premultiplying by a random number */
+    vli_modMult_n(k, k, tmp, curve);                    /* k' = rand * k */
+    uECC_vli_modInv(k, k, curve->n, num_n_words);       /* k = 1 / k' */
+    vli_modMult_n(k, k, tmp, curve);                    /* k = 1 / k */
+#endif
+
+    return sign_with_inverse_k(private_key, message_hash, hash_size, k, p, signature, curve);
+}
 /*
 // rfc6979 pseudo random number generator state
 typedef struct {
@@ -1401,14 +1695,14 @@ static void gen_dk(const uint8_t *privateKey, const uint8_t *digest, uint8_t *k,
     // (junk) (digest) (junk)
 
     for (uint32_t i = 0; i < iteration; i++) {
-        ethers_keccak256(&scratch[32], 32, &scratch[0]);
+        ethers_keccak256_short(&scratch[32], 32, &scratch[0]);
         memcpy(&scratch[32], &scratch[0], 32);
     }
 
     // (junk) (digest_i = digest ** iterations) (junk)
 
     uint8_t kPrime[32];
-    ethers_keccak256(privateKey, 32, kPrime);
+    ethers_keccak256_short(privateKey, 32, kPrime);
 
     // Compute inner hash
     memcpy(&scratch[0], kPrime, 32);
@@ -1419,7 +1713,7 @@ static void gen_dk(const uint8_t *privateKey, const uint8_t *digest, uint8_t *k,
 
     // (inner = k_prime ^ 0x36) (digest_i) (junk)
 
-    ethers_keccak256(scratch, 64, &scratch[64]);
+    ethers_keccak256_short(scratch, 64, &scratch[64]);
 
     // (inner) (digest_i) (inner_2 = keccak(inner || digest_i))
 
@@ -1435,7 +1729,7 @@ static void gen_dk(const uint8_t *privateKey, const uint8_t *digest, uint8_t *k,
 
     // (outter = k_prime ^ 0x5c) (inner_2) (inner_2)
 
-    ethers_keccak256(scratch, 64, &scratch[64]);
+    ethers_keccak256_short(scratch, 64, &scratch[64]);
 
     // (outter) (inner_2) (outter_2 = keccak(outter || inner_2))
 
@@ -1464,6 +1758,181 @@ int uECC_sign(const uint8_t *private_key,
     return 0;
 }
 
+int uECC_sign_batch(const uint8_t *private_key,
+                    const uint8_t *message_hashes,
+                    unsigned hash_size,
+                    uint8_t *signatures,
+                    unsigned count,
+                    uECC_Curve curve) {
+    uECC_word_t k[uECC_BATCH_SIZE * uECC_MAX_WORDS];
+    uECC_word_t p[uECC_BATCH_SIZE * uECC_MAX_WORDS * 2];
+    uECC_word_t Z[uECC_BATCH_SIZE * uECC_MAX_WORDS];
+    uECC_word_t scratch[uECC_BATCH_SIZE * uECC_MAX_WORDS];
+#if !uECC_SAFEGCD_INVERSE
+    uECC_word_t blind[uECC_MAX_WORDS];
+#endif
+    uint8_t valid[uECC_BATCH_SIZE];
+    uint8_t generatedK[32];
+    uECC_word_t jacobian = 0;
+    wordcount_t num_words = curve->num_words;
+    wordcount_t num_n_words = BITS_TO_WORDS(curve->num_n_bits);
+    unsigned batch;
+    unsigned i;
+
+    while (count > 0) {
+        batch = (count < uECC_BATCH_SIZE) ? count : uECC_BATCH_SIZE;
+
+        /* Compute k * G for the first nonce uECC_sign() would try, without the inversion. */
+        for (i = 0; i < batch; ++i) {
+            uECC_word_t *k_i = k + i * num_words;
+            gen_dk(private_key, message_hashes + i * hash_size, generatedK, 0);
+            uECC_vli_bytesToNative(k_i, generatedK, 32);
+
+            /* A nonce outside [1, n-1] is left to uECC_sign() below; use 1 as a stand-in so
+               the shared inversions stay valid. */
+            valid[i] = !uECC_vli_isZero(k_i, num_words) &&
+                uECC_vli_cmp(curve->n, k_i, num_n_words) == 1;
+            if (!valid[i]) {
+                uECC_vli_clear(k_i, num_words);
+                k_i[0] = 1;
+            }
+
+            jacobian = EccPoint_mult_G_projective(
+                p + 2 * i * num_words, Z + i * num_words, k_i, curve);
+        }
+
+        EccPoint_normalize_batch(p, Z, scratch, batch, jacobian, curve);
+
+#if uECC_SAFEGCD_INVERSE
+        /* Invert all nonces at once. The inversion runs in constant time, so they need no
+           blinding. */
+        vli_modInv_batch(k, scratch, batch, curve->n, &vli_modMult_n, curve);
+#else
+        /* Invert all nonces at once. If an RNG function was specified, blind them with a
+           shared random number to prevent side channel analysis of uECC_vli_modInv(). */
+        if (g_rng_function) {
+            if (!uECC_generate_random_int(blind, curve->n, num_n_words)) {
+                return 0;
+            }
+            for (i = 0; i < batch; ++i) {
+                vli_modMult_n(k + i * num_words, k + i * num_words, blind, curve);
+            }
+        }
+        vli_modInv_batch(k, scratch, batch, curve->n, &vli_modMult_n, curve);
+        if (g_rng_function) {
+            for (i = 0; i < batch; ++i) {
+                vli_modMult_n(k + i * num_words, k + i * num_words, blind, curve);
+            }
+        }
+#endif
+
+        for (i = 0; i < batch; ++i) {
+            const uint8_t *message_hash = message_hashes + i * hash_size;
+            uint8_t *signature = signatures + 2 * i * curve->num_bytes;
+            const uECC_word_t *p_i = p + 2 * i * num_words;
+            if (valid[i] && !uECC_vli_isZero(p_i, num_words) &&
+                    sign_with_inverse_k(private_key, message_hash, hash_size,
+                                        k + i * num_words, p_i, signature, curve)) {
+                continue;
+            }
+            /* Rare: let uECC_sign() move on to the next nonce. */
+            if (!uECC_sign(private_key, message_hash, hash_size, signature, curve)) {
+                return 0;
+            }
+        }
+
+        message_hashes += batch * hash_size;
+        signatures += batch * 2 * curve->num_bytes;
+        count -= batch;
+    }
+
+    return 1;
+}
+
+/* Presignature layout: r | 1 / k | parity of the y coordinate of k * G. */
+int uECC_presign(const uint8_t *private_key,
+                 const uint8_t *seed,
+                 uint8_t *presignature,
+                 uECC_Curve curve) {
+    uECC_word_t k[uECC_MAX_WORDS];
+    uECC_word_t p[uECC_MAX_WORDS * 2];
+    wordcount_t num_words = curve->num_words;
+    wordcount_t num_n_words = BITS_TO_WORDS(curve->num_n_bits);
+    uint8_t generatedK[32];
+    uECC_word_t tries;
+
+    for (tries = 0; tries < uECC_RNG_MAX_TRIES; ++tries) {
+        gen_dk(private_key, seed, generatedK, tries);
+        uECC_vli_bytesToNative(k, generatedK, 32);
+
+        /* Make sure 0 < k < curve_n */
+        if (uECC_vli_isZero(k, num_words) || uECC_vli_cmp(curve->n, k, num_n_words) != 1) {
+            continue;
+        }
+
+        EccPoint_mult_G(p, k, curve);
+        if (uECC_vli_isZero(p, num_words)) {
+            continue;
+        }
+
+        /* As in uECC_sign_with_k(), k is only blinded when the inversion is not constant
+           time and an RNG function was specified. */
+#if uECC_SAFEGCD_INVERSE
+        uECC_vli_modInv(k, k, curve->n, num_n_words);
+#else
+        if (!g_rng_function) {
+            uECC_vli_modInv(k, k, curve->n, num_n_words);
+        } else {
+            uECC_word_t blind[uECC_MAX_WORDS];
+            if (!uECC_generate_random_int(blind, curve->n, num_n_words)) {
+                return 0;
+            }
+            vli_modMult_n(k, k, blind, curve);
+            uECC_vli_modInv(k, k, curve->n, num_n_words);
+            vli_modMult_n(k, k, blind, curve);
+        }
+#endif
+
+        uECC_vli_nativeToBytes(presignature, curve->num_bytes, p);
+        uECC_vli_nativeToBytes(presignature + curve->num_bytes, curve->num_bytes, k);
+        presignature[2 * curve->num_bytes] = p[num_words] & 0x01;
+        memset(generatedK, 0, sizeof(generatedK));
+        uECC_vli_clear(k, num_words);
+        return 1;
+    }
+
+    return 0;
+}
+
+int uECC_sign_with_presig(const uint8_t *private_key,
+                          const uint8_t *message_hash,
+                          unsigned hash_size,
+                          uint8_t *presignature,
+                          uint8_t *signature,
+                          uECC_Curve curve) {
+    uECC_word_t k_inv[uECC_MAX_WORDS];
+    uECC_word_t p[uECC_MAX_WORDS * 2];
+    wordcount_t num_words = curve->num_words;
+    wordcount_t num_n_words = BITS_TO_WORDS(curve->num_n_bits);
+    int success;
+
+    uECC_vli_bytesToNative(p, presignature, curve->num_bytes);
+    uECC_vli_bytesToNative(k_inv, presignature + curve->num_bytes, curve->num_bytes);
+    uECC_vli_clear(p + num_words, num_words);
+    p[num_words] = presignature[2 * curve->num_bytes] & 0x01;
+
+    /* Whatever happens below, the nonce is spent. */
+    memset(presignature, 0, 2 * curve->num_bytes + 1);
+
+    if (uECC_vli_isZero(p, num_words) || uECC_vli_isZero(k_inv, num_n_words)) {
+        return 0;
+    }
+
+    success = sign_with_inverse_k(private_key, message_hash, hash_size, k_inv, p, signature, curve);
+    uECC_vli_clear(k_inv, num_words);
+    return success;
+}
+
 /* Compute an HMAC using K as a key (as in RFC 6979). Note that K is always
    the same size as the hash result size. */
 static void HMAC_init(const uECC_HashContext *hash_context, const uint8_t *K) {
@@ -1592,6 +2061,18 @@ static bitcount_t smax(bitcount_t a, bitcount_t b) {
     return (a > b ? a : b);
 }
 
+static int verify_x_matches_r(uECC_word_t *rx, const uECC_word_t *r, uECC_Curve curve) {
+    wordcount_t num_n_words = BITS_TO_WORDS(curve->num_n_bits);
+
+    /* v = x1 (mod n) */
+    if (uECC_vli_cmp_unsafe(curve->n, rx, num_n_words) != 1) {
+        uECC_vli_sub(rx, rx, curve->n, num_n_words);
+    }
+
+    /* Accept only if v == r. */
+    return (int)(uECC_vli_equal(rx, r, curve->num_words));
+}
+
 int uECC_verify(const uint8_t *public_key,
                 const uint8_t *message_hash,
                 unsigned hash_size,
@@ -1651,6 +2132,14 @@ int uECC_verify(const uint8_t *public_key,
     uECC_vli_modMult(u1, u1, z, curve->n, num_n_words); /* u1 = e/s */
     uECC_vli_modMult(u2, r, z, curve->n, num_n_words); /* u2 = r/s */
 
+#if uECC_GLV_ENDOMORPHISM
+    if (curve->double_mult) {
+        curve->double_mult(sum, u1, _public, u2, curve);
+        uECC_vli_set(rx, sum, num_words);
+        return verify_x_matches_r(rx, r, curve);
+    }
+#endif
+
     /* Calculate sum = G + Q. */
     uECC_vli_set(sum, _public, num_words);
     uECC_vli_set(sum + num_words, _public + num_words, num_words);
@@ -1695,13 +2184,7 @@ int uECC_verify(const uint8_t *public_key,
     uECC_vli_modInv(z, z, curve->p, num_words); /* Z = 1/Z */
     apply_z(rx, ry, z, curve);
 
-    /* v = x1 (mod n) */
-    if (uECC_vli_cmp_unsafe(curve->n, rx, num_n_words) != 1) {
-        uECC_vli_sub(rx, rx, curve->n, num_n_words);
-    }
-
-    /* Accept only if v == r. */
-    return (int)(uECC_vli_equal(rx, r, num_words));
+    return verify_x_matches_r(rx, r, curve);
 }
 
 #if uECC_ENABLE_VLI_API
@@ -1767,8 +2250,17 @@ void uECC_point_mult(uECC_word_t *result,
     uECC_word_t tmp1[uECC_MAX_WORDS];
     uECC_word_t tmp2[uECC_MAX_WORDS];
     uECC_word_t *p2[2] = {tmp1, tmp2};
-    uECC_word_t carry = regularize_k(scalar, tmp1, tmp2, curve);
+    uECC_word_t carry;
+
+#if uECC_GLV_ENDOMORPHISM
+    if (curve->mult_point) {
+        curve->mult_point(result, result + curve->num_words, tmp1, point, scalar, 0, curve);
+        EccPoint_normalize_batch(result, tmp1, tmp2, 1, 0, curve);
+        return;
+    }
+#endif
 
+    carry = regularize_k(scalar, tmp1, tmp2, curve);
     EccPoint_mult(result, point, p2[!carry], 0, curve->num_n_bits + 1, curve);
 }
 
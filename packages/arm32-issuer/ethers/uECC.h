@@ -75,6 +75,30 @@ the same endianness. */
     #define uECC_SUPPORT_COMPRESSED_POINT 0
 #endif
 
+/* uECC_FIXED_BASE_COMB - If enabled (defined as nonzero), multiplication by the generator on
+   secp256k1 (public key computation and signing) uses a constant-time comb over a precomputed
+   table of multiples of G instead of the Montgomery ladder. This is several times faster,
+   but adds about 4KB of constant data. */
+#ifndef uECC_FIXED_BASE_COMB
+    #define uECC_FIXED_BASE_COMB 1
+#endif
+
+/* uECC_GLV_ENDOMORPHISM - If enabled (defined as nonzero), multiplication of arbitrary points on
+   secp256k1 (ECDH and signature verification) uses the curve's endomorphism to split the scalar
+   into two 128-bit halves that are processed together, roughly halving the number of point
+   doublings. */
+#ifndef uECC_GLV_ENDOMORPHISM
+    #define uECC_GLV_ENDOMORPHISM 1
+#endif
+
+/* uECC_SAFEGCD_INVERSE - If enabled (defined as nonzero), modular inversion uses the
+   constant-time divsteps algorithm of Bernstein and Yang instead of the binary extended GCD.
+   It is faster, and since its timing does not depend on the input, signing no longer blinds
+   the nonce before inverting it. */
+#ifndef uECC_SAFEGCD_INVERSE
+    #define uECC_SAFEGCD_INVERSE 1
+#endif
+
 struct uECC_Curve_t;
 typedef const struct uECC_Curve_t * uECC_Curve;
 
@@ -235,6 +259,24 @@ Returns 1 if the key was computed successfully, 0 if an error occurred.
 */
 int uECC_compute_public_key(const uint8_t *private_key, uint8_t *public_key, uECC_Curve curve);
 
+/* uECC_compute_public_keys() function.
+Compute the public keys for count private keys. This gives the same results as calling
+uECC_compute_public_key() for each key, but shares one modular inversion between several keys.
+
+Inputs:
+    private_keys - The private keys, one after another
+    count        - The number of private keys
+
+Outputs:
+    public_keys - Will be filled in with the corresponding public keys, one after another
+
+Returns 1 if the keys were computed successfully, 0 if an error occurred.
+*/
+int uECC_compute_public_keys(const uint8_t *private_keys,
+                             uint8_t *public_keys,
+                             unsigned count,
+                             uECC_Curve curve);
+
 /* uECC_sign() function.
 Generate an ECDSA signature for a given hash value.
 
@@ -258,6 +300,77 @@ int uECC_sign(const uint8_t *private_key,
               uint8_t *signature,
               uECC_Curve curve);
 
+/* uECC_sign_batch() function.
+Generate ECDSA signatures for count hash values with the same private key. This gives the same
+signatures as calling uECC_sign() for each hash, but computes the nonce points and the nonce
+inverses with one modular inversion each per batch of hashes.
+
+Inputs:
+    private_key    - Your private key.
+    message_hashes - The hashes of the messages to sign, one after another.
+    hash_size      - The size of each message hash in bytes.
+    count          - The number of hashes.
+
+Outputs:
+    signatures - Will be filled in with the signature values, one after another. Must be at
+                 least count * 2 * curve size long.
+
+Returns 1 if the signatures generated successfully, 0 if an error occurred.
+*/
+int uECC_sign_batch(const uint8_t *private_key,
+                    const uint8_t *message_hashes,
+                    unsigned hash_size,
+                    uint8_t *signatures,
+                    unsigned count,
+                    uECC_Curve curve);
+
+/* uECC_presign() function.
+Precompute the message independent part of an ECDSA signature: the nonce point r = k * G and
+the nonce inverse 1 / k. Finishing the signature with uECC_sign_with_presig() then only costs
+a few multiplications modulo n.
+
+The nonce k is derived from private_key and seed the way uECC_sign() derives it from the
+message hash, so the caller must make sure that a seed is never used for two different
+messages, and that it cannot equal the hash of a message signed with uECC_sign().
+
+Inputs:
+    private_key - Your private key.
+    seed        - 32 bytes that select the nonce.
+
+Outputs:
+    presignature - Will be filled in with the presignature. Must be 2 * curve size + 1 bytes
+                   long.
+
+Returns 1 if the presignature was computed successfully, 0 if an error occurred.
+*/
+int uECC_presign(const uint8_t *private_key,
+                 const uint8_t *seed,
+                 uint8_t *presignature,
+                 uECC_Curve curve);
+
+/* uECC_sign_with_presig() function.
+Generate an ECDSA signature for a given hash value from a presignature computed by
+uECC_presign() with the same private key. The presignature is wiped, even on failure, so
+that its nonce cannot be used for a second message.
+
+Inputs:
+    private_key  - Your private key.
+    message_hash - The hash of the message to sign.
+    hash_size    - The size of message_hash in bytes.
+    presignature - The presignature to use up.
+
+Outputs:
+    signature - Will be filled in with the signature value. Must be at least 2 * curve size long.
+
+Returns 1 if the signature generated successfully, 0 if an error occurred.
+*/
+int uECC_sign_with_presig(const uint8_t *private_key,
+                          const uint8_t *message_hash,
+                          unsigned hash_size,
+                          uint8_t *presignature,
+                          uint8_t *signature,
+                          uECC_Curve curve);
+
 /* uECC_HashContext structure.
 This is used to pass in an arbitrary hash function to uECC_sign_deterministic().
 The structure will be used for multiple hash computations; each time a new hash
@@ -0,0 +1,65 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// Each benchmark is a program built once per variant of the code it measures (see the
+// Makefile); its name, which carries the variant, labels every line it prints.
+
+static const char *bench_program = "bench";
+static FILE *bench_out = stdout;    // Where results go, for programs that silence stdout
+
+static inline void bench_init(char **argv) {
+    const char *slash = strrchr(argv[0], '/');
+    bench_program = slash ? slash + 1 : argv[0];
+}
+
+// CPU time used by the process, which leaves out time the machine spent on anything else
+static inline double bench_cpu_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Prints one result line
+static inline void bench_report(const char *name, double ns) {
+    fprintf(bench_out, "%-24s %-32s %12.1f ns\n", bench_program, name, ns);
+    fflush(bench_out);
+}
+
+// Calls fn in 20 rounds of at least 20ms of CPU time each, and prints the mean time per item in
+// the fastest round, where each call handles 'items' of them; the fastest round is the one
+// least disturbed by the rest of the machine. Returns that time in nanoseconds.
+template<typename F>
+static double bench(const char *name, F fn, unsigned items = 1) {
+    fn();   // Warm up caches and any lazily set up state
+
+    double best = 0;
+    for(int round = 0; round < 20; round++) {
+        // Reads the clock less often as it goes, so it costs little next to short calls
+        unsigned long calls = 0, batch = 1;
+        double elapsed;
+        double start = bench_cpu_ns();
+        do {
+            for(unsigned long i = 0; i < batch; i++) {
+                fn();
+            }
+            calls += batch;
+            if(batch < 1024) {
+                batch *= 2;
+            }
+            elapsed = bench_cpu_ns() - start;
+        } while(elapsed < 20e6);
+
+        double ns = elapsed / ((double)calls * items);
+        if(round == 0 || ns < best) {
+            best = ns;
+        }
+    }
+    bench_report(name, best);
+    return best;
+}
+
+#endif
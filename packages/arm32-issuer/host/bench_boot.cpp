@@ -0,0 +1,39 @@
+// The issuer work on the boot path: load_issuer with the address cache in place, as on every boot
+// after the first, and without it, against get_issuer_address, which every boot used to run. The
+// host's DeviceKey (sim.cpp) is cheaper than the real one, which adds the same two CMAC
+// derivations to each.
+
+#include "bench.h"
+#include "sim.h"
+#include "mbed_error.h"
+#include "kvstore_global_api.h"
+#include "config.h"
+#include "storage.h"
+
+#include <string.h>
+
+int main(int argc, char **argv) {
+    bench_init(argv);
+    sim_kv_clear();
+
+    privkey_t privkey;
+    address_t address, cached;
+    if(get_issuer_address(address) != MBED_SUCCESS
+            || load_issuer(privkey, cached) != MBED_SUCCESS || memcmp(address, cached, sizeof(address)) != 0
+            || load_issuer(privkey, cached) != MBED_SUCCESS || memcmp(address, cached, sizeof(address)) != 0) {
+        printf("%s: setup failed\n", bench_program);
+        return 1;
+    }
+
+    bench("get_issuer_address", [&]() {
+        get_issuer_address(address);
+    });
+    bench("load_issuer cold", [&]() {
+        kv_remove(ISSUER_CACHE_KEY_PATH);
+        load_issuer(privkey, address);
+    });
+    bench("load_issuer cached", [&]() {
+        load_issuer(privkey, address);
+    });
+    return 0;
+}
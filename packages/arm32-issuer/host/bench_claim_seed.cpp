@@ -0,0 +1,83 @@
+// Per-claim seed cost: claim_seed on the keccak PRF path, against the DeviceKey derivation every
+// claim used to run. The host's DeviceKey (sim.cpp) is not the real one, so that derivation is
+// reproduced here the way mbed's DeviceKey does it: the root of trust is read from KVStore and
+// used as an AES-128 key for a CMAC counter-mode KDF (NIST SP 800-108) over the salt.
+
+#include "bench.h"
+#include "sim.h"
+#include "mbed_error.h"
+#include "kvstore_global_api.h"
+#include "claim_seed.h"
+#include "storage.h"
+
+#include <openssl/evp.h>
+#include <openssl/params.h>
+#include <string.h>
+
+#define ROT_KEY_PATH "/kv/bench_rot"
+
+extern uint32_t seed_prf_start;
+
+static EVP_MAC *cmac;
+
+static int devicekey_kdf(const uint8_t *salt, size_t salt_size, uint8_t *output, size_t output_size) {
+    uint8_t rot[16];
+    size_t rot_size;
+    int ret = kv_get(ROT_KEY_PATH, rot, sizeof(rot), &rot_size);
+    if(ret != MBED_SUCCESS) {
+        return ret;
+    }
+
+    char cipher[] = "AES-128-CBC";
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_utf8_string("cipher", cipher, 0),
+        OSSL_PARAM_construct_end()
+    };
+    uint32_t length_bits = output_size * 8;
+    uint8_t separator = 0;
+    for(uint8_t counter = 1; (size_t)(counter - 1) * 16 < output_size; counter++) {
+        uint8_t block[16];
+        size_t block_size;
+        EVP_MAC_CTX *ctx = EVP_MAC_CTX_new(cmac);
+        bool ok = ctx && EVP_MAC_init(ctx, rot, sizeof(rot), params)
+            && EVP_MAC_update(ctx, &counter, 1)
+            && EVP_MAC_update(ctx, salt, salt_size)
+            && EVP_MAC_update(ctx, &separator, 1)
+            && EVP_MAC_update(ctx, (uint8_t*)&length_bits, sizeof(length_bits))
+            && EVP_MAC_final(ctx, block, &block_size, sizeof(block));
+        EVP_MAC_CTX_free(ctx);
+        if(!ok) {
+            return MBED_ERROR_FAILED_OPERATION;
+        }
+        size_t n = output_size - (counter - 1) * 16 < 16 ? output_size - (counter - 1) * 16 : 16;
+        memcpy(output + (counter - 1) * 16, block, n);
+    }
+    memset(rot, 0, sizeof(rot));
+    return MBED_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+    bench_init(argv);
+
+    uint8_t rot[16] = {0x5b, 0x22, 0x26, 0xba, 0x20, 0x3d, 0x95, 0x1e};
+    sim_kv_clear();
+    cmac = EVP_MAC_fetch(NULL, "CMAC", NULL);
+    if(!cmac || kv_set(ROT_KEY_PATH, rot, sizeof(rot), 0) != MBED_SUCCESS
+            || claim_seed_init() != MBED_SUCCESS) {
+        printf("%s: setup failed\n", bench_program);
+        return 1;
+    }
+    seed_prf_start = 0;
+
+    seed_t seed;
+    uint32_t nonce = 0;
+    bench("claim_seed, keccak PRF", [&]() {
+        claim_seed(nonce++, seed);
+    });
+    bench("DeviceKey KDF, AES-CMAC", [&]() {
+        devicekey_kdf((uint8_t*)&nonce, sizeof(nonce), seed, SEED_LENGTH);
+        nonce++;
+    });
+    EVP_MAC_free(cmac);
+    return 0;
+}
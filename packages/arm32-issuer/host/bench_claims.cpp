@@ -0,0 +1,86 @@
+// Claim generation on a host issuer: generate_claim_codes against a loop over
+// generate_claim_code, and the batch key and signature functions under them against their
+// one-at-a-time versions.
+
+#include "bench.h"
+#include "sim.h"
+#include "mbed_error.h"
+#include "claims.h"
+#include "claim_seed.h"
+#include "storage.h"
+#include "uECC.h"
+
+#include <string.h>
+#include <unistd.h>
+
+#define COUNT 64
+
+int main(int argc, char **argv) {
+    bench_init(argv);
+    // Claim generation prints each code; keep that out of the timings
+    fflush(stdout);
+    bench_out = fdopen(dup(fileno(stdout)), "w");
+    if(!bench_out || !freopen("/dev/null", "w", stdout)) {
+        return 1;
+    }
+    uECC_Curve curve = uECC_secp256k1();
+
+    privkey_t issuer_key;
+    address_t validator = {0x11};
+    sim_kv_clear();
+    if(get_issuer_key(issuer_key) != MBED_SUCCESS || claim_seed_init() != MBED_SUCCESS) {
+        fprintf(bench_out, "%s: setup failed\n", bench_program);
+        return 1;
+    }
+
+    static char codes[COUNT][CLAIMCODE_LEN + 1];
+    static char batch_codes[COUNT][CLAIMCODE_LEN + 1];
+    char *batch_ptrs[COUNT];
+    for(int i = 0; i < COUNT; i++) {
+        batch_ptrs[i] = batch_codes[i];
+    }
+
+    // Signatures are deterministic, so both ways must give the same codes
+    for(int i = 0; i < COUNT; i++) {
+        generate_claim_code(issuer_key, validator, i, codes[i]);
+    }
+    generate_claim_codes(issuer_key, validator, 0, batch_ptrs, COUNT);
+    if(memcmp(codes, batch_codes, sizeof(codes)) != 0) {
+        fprintf(bench_out, "%s: batch codes differ\n", bench_program);
+        return 1;
+    }
+
+    bench("generate_claim_code, per claim", [&]() {
+        for(int i = 0; i < COUNT; i++) {
+            generate_claim_code(issuer_key, validator, i, codes[i]);
+        }
+    }, COUNT);
+    bench("generate_claim_codes, per claim", [&]() {
+        generate_claim_codes(issuer_key, validator, 0, batch_ptrs, COUNT);
+    }, COUNT);
+
+    static uint8_t privkeys[COUNT][32], pubkeys[COUNT][64], hashes[COUNT][32], sigs[COUNT][64];
+    for(int i = 0; i < COUNT; i++) {
+        memset(privkeys[i], 0x22, 32);
+        privkeys[i][31] = i + 1;
+        memset(hashes[i], 0x33, 32);
+        hashes[i][0] = i;
+    }
+    bench("compute_public_key, per key", [&]() {
+        for(int i = 0; i < COUNT; i++) {
+            uECC_compute_public_key(privkeys[i], pubkeys[i], curve);
+        }
+    }, COUNT);
+    bench("compute_public_keys, per key", [&]() {
+        uECC_compute_public_keys(privkeys[0], pubkeys[0], COUNT, curve);
+    }, COUNT);
+    bench("sign, per signature", [&]() {
+        for(int i = 0; i < COUNT; i++) {
+            uECC_sign(issuer_key, hashes[i], 32, sigs[i], curve);
+        }
+    }, COUNT);
+    bench("sign_batch, per signature", [&]() {
+        uECC_sign_batch(issuer_key, hashes[0], 32, sigs[0], COUNT, curve);
+    }, COUNT);
+    return 0;
+}
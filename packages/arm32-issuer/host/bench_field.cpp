@@ -0,0 +1,59 @@
+// secp256k1 field arithmetic on 64-bit hosts, built as bench_field (the x86-64 backend, using
+// MULX/ADX when the CPU has them), bench_field-nomulx (the backend's __int128 code only) and
+// bench_field-portable (the generic C path with 64-bit words).
+
+#include "bench.h"
+#include "uECC.h"
+#include "uECC_vli.h"
+
+#include <string.h>
+
+#define NUM_WORDS (32 / sizeof(uECC_word_t))
+
+int main(int argc, char **argv) {
+    bench_init(argv);
+    uECC_Curve curve = uECC_secp256k1();
+    wordcount_t num_words = NUM_WORDS;
+
+    uECC_word_t a[NUM_WORDS], b[NUM_WORDS], result[NUM_WORDS], product[2 * NUM_WORDS];
+    memset(a, 0xA7, sizeof(a));
+    memset(b, 0x3C, sizeof(b));
+    a[0] ^= 0x1234;
+
+    // The backends must agree with the generic reduction
+    uECC_vli_modMult_fast(result, a, b, curve);
+    uECC_vli_mult(product, a, b, num_words);
+    uECC_word_t check[NUM_WORDS];
+    uECC_vli_mmod(check, product, uECC_curve_p(curve), num_words);
+    if(!uECC_vli_equal(result, check, num_words)) {
+        printf("%s: wrong product\n", bench_program);
+        return 1;
+    }
+
+    bench("vli_mult", [&]() {
+        uECC_vli_mult(product, a, b, num_words);
+    });
+    bench("vli_square", [&]() {
+        uECC_vli_square(product, a, num_words);
+    });
+    bench("modMult_fast", [&]() {
+        uECC_vli_modMult_fast(result, result, b, curve);
+    });
+    bench("modSquare_fast", [&]() {
+        uECC_vli_modSquare_fast(result, result, curve);
+    });
+
+    uint8_t privkey[32], pubkey[64], hash[32] = {0x5E}, sig[64];
+    memset(privkey, 0x42, sizeof(privkey));
+    uECC_compute_public_key(privkey, pubkey, curve);
+    bench("compute_public_key", [&]() {
+        uECC_compute_public_key(privkey, pubkey, curve);
+    });
+    bench("sign", [&]() {
+        uECC_sign(privkey, hash, sizeof(hash), sig, curve);
+    });
+    bench("verify", [&]() {
+        uECC_verify(pubkey, hash, sizeof(hash), sig, curve);
+    });
+    return 0;
+}
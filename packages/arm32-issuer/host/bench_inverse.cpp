@@ -0,0 +1,48 @@
+// Modular inversion, built as bench_inverse (safegcd) and bench_inverse-bingcd (the binary
+// extended GCD). safegcd should take the same time for any input; the binary GCD takes less
+// for inputs with short remainders, such as small numbers.
+
+#include "bench.h"
+#include "uECC.h"
+#include "uECC_vli.h"
+
+#include <string.h>
+
+#define NUM_WORDS (32 / sizeof(uECC_word_t))
+
+int main(int argc, char **argv) {
+    bench_init(argv);
+    uECC_Curve curve = uECC_secp256k1();
+    wordcount_t num_words = NUM_WORDS;
+
+    uECC_word_t input[NUM_WORDS], small[NUM_WORDS];
+    uECC_word_t result[NUM_WORDS], check[NUM_WORDS];
+    memset(input, 0xA7, sizeof(input));
+    input[0] ^= 0x1234;
+    uECC_vli_clear(small, num_words);
+    small[0] = 3;
+
+    // Each inverse must multiply back to 1
+    const uECC_word_t *moduli[2] = {uECC_curve_p(curve), uECC_curve_n(curve)};
+    for(int m = 0; m < 2; m++) {
+        uECC_vli_modInv(result, input, moduli[m], num_words);
+        uECC_vli_modMult(check, result, input, moduli[m], num_words);
+        uECC_vli_clear(result, num_words);
+        result[0] = 1;
+        if(!uECC_vli_equal(check, result, num_words)) {
+            printf("%s: wrong inverse\n", bench_program);
+            return 1;
+        }
+    }
+
+    bench("modInv mod p, random input", [&]() {
+        uECC_vli_modInv(result, input, uECC_curve_p(curve), num_words);
+    });
+    bench("modInv mod p, input 3", [&]() {
+        uECC_vli_modInv(result, small, uECC_curve_p(curve), num_words);
+    });
+    bench("modInv mod n, random input", [&]() {
+        uECC_vli_modInv(result, input, uECC_curve_n(curve), num_words);
+    });
+    return 0;
+}
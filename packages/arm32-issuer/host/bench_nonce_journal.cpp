@@ -0,0 +1,58 @@
+// Latency of the nonce reservation write, set_stored_nonce, in device time on the simulated
+// flash (sim.h) rather than host time. Built as bench_nonce_journal (the flash journal, with its
+// spare sector erased between writes as maintain_store does when idle) and
+// bench_nonce_journal-kv (the KVStore path, which now and then runs into TDBStore garbage
+// collection). Each reports the p50, p99, p99.9 and max of 100000 writes.
+
+#include "bench.h"
+#include "sim.h"
+#include "mbed_error.h"
+#include "kvstore_global_api.h"
+#include "config.h"
+#include "nonce_journal.h"
+
+#include <algorithm>
+#include <string.h>
+#include <vector>
+
+#define WRITES 100000
+
+int set_stored_nonce(uint32_t nonce);
+
+int main(int argc, char **argv) {
+    bench_init(argv);
+    sim_kv_clear();
+    memset(sim_flash, 0xFF, sizeof(sim_flash));
+
+    // The rest of what the firmware keeps in KVStore, which garbage collection copies
+    uint8_t issuer_cache[52] = {0}, boot_stats[20] = {0};
+    uint32_t seed_prf_start = 0;
+    kv_set(ISSUER_CACHE_KEY_PATH, issuer_cache, sizeof(issuer_cache), 0);
+    kv_set(SEED_PRF_START_KEY_PATH, &seed_prf_start, sizeof(seed_prf_start), 0);
+    kv_set(BOOT_STATS_KEY_PATH, boot_stats, sizeof(boot_stats), 0);
+
+    std::vector<double> latencies;
+    latencies.reserve(WRITES);
+    for(uint32_t i = 1; i <= WRITES; i++) {
+        uint64_t start = sim_flash_ns;
+        if(set_stored_nonce(i * 256) != MBED_SUCCESS) {
+            printf("%s: write %u failed\n", bench_program, (unsigned)i);
+            return 1;
+        }
+        latencies.push_back(sim_flash_ns - start);
+#if NONCE_JOURNAL
+        if(nonce_journal_maintain() != MBED_SUCCESS) {
+            printf("%s: maintenance failed\n", bench_program);
+            return 1;
+        }
+#endif
+    }
+
+    // Nearest-rank percentiles
+    std::sort(latencies.begin(), latencies.end());
+    bench_report("set_stored_nonce p50", latencies[WRITES / 2]);
+    bench_report("set_stored_nonce p99", latencies[WRITES * 99 / 100]);
+    bench_report("set_stored_nonce p99.9", latencies[WRITES * 999 / 1000]);
+    bench_report("set_stored_nonce max", latencies.back());
+    return 0;
+}
@@ -0,0 +1,41 @@
+// Point multiplication on secp256k1, built as bench_point (comb and GLV), bench_point-glv (GLV
+// for the generator too) and bench_point-ladder (the Montgomery ladder throughout). The -w32
+// builds use 32-bit words as on the device, with the lazy 10x26 field (bench_point-w32) or with
+// fully reduced words (bench_point-w32-reduced).
+
+#include "bench.h"
+#include "uECC.h"
+
+#include <stdint.h>
+
+int main(int argc, char **argv) {
+    bench_init(argv);
+    uECC_Curve curve = uECC_secp256k1();
+
+    uint8_t privkey[32], peer_privkey[32];
+    for(int i = 0; i < 32; i++) {
+        privkey[i] = 0x11 * (i + 1);
+        peer_privkey[i] = 0x5A ^ (7 * i);
+    }
+    uint8_t pubkey[64], peer_pubkey[64], secret[32];
+    uint8_t hash[32] = {0xC4, 0x2D}, sig[64];
+    if(!uECC_compute_public_key(privkey, pubkey, curve)
+            || !uECC_compute_public_key(peer_privkey, peer_pubkey, curve)
+            || !uECC_sign(privkey, hash, sizeof(hash), sig, curve)
+            || !uECC_verify(pubkey, hash, sizeof(hash), sig, curve)
+            || uECC_verify(peer_pubkey, hash, sizeof(hash), sig, curve)) {
+        printf("%s: setup failed\n", bench_program);
+        return 1;
+    }
+
+    bench("compute_public_key", [&]() {
+        uECC_compute_public_key(privkey, pubkey, curve);
+    });
+    bench("shared_secret", [&]() {
+        uECC_shared_secret(peer_pubkey, privkey, secret, curve);
+    });
+    bench("verify", [&]() {
+        uECC_verify(pubkey, hash, sizeof(hash), sig, curve);
+    });
+    return 0;
+}
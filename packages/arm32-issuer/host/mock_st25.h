@@ -0,0 +1,16 @@
+#ifndef MOCK_ST25_H
+#define MOCK_ST25_H
+
+#include "st25.h"
+
+// The ST25 driver with its simulated device (st25_mock_i2c.h) in reach, for host tests
+class MockST25 : public ST25 {
+public:
+    MockST25(PinName sda, PinName scl) : ST25(sda, scl) {}
+
+    MockI2C &mock() {
+        return i2c;
+    }
+};
+
+#endif
@@ -0,0 +1,161 @@
+#include "nonce_lease.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define LEASE_MAGIC 0x4C4E4558
+
+/*
+ * The file holds two copies of this record. Each update goes to the copy the last one didn't, so
+ * a write torn by a crash leaves the previous record readable; the valid copy with the higher
+ * sequence number is current.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t check;             // FNV-1a of the fields below
+    uint64_t sequence;
+    uint64_t unleased;          // First nonce not yet leased to any process
+    uint64_t reserved;
+} lease_record_t;
+
+static uint32_t record_check(const lease_record_t *record) {
+    const uint8_t *data = (const uint8_t*)&record->sequence;
+    uint32_t hash = 0x811C9DC5;
+    for(size_t i = 0; i < sizeof(lease_record_t) - offsetof(lease_record_t, sequence); i++) {
+        hash = (hash ^ data[i]) * 0x01000193;
+    }
+    return hash;
+}
+
+NonceLease::NonceLease(uint64_t lease_size) : lease_size(lease_size), fd(-1), next_nonce(0), lease_end(0) {}
+
+NonceLease::~NonceLease() {
+    close();
+}
+
+int NonceLease::open(const char *path) {
+    fd = ::open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if(fd < 0) {
+        return -errno;
+    }
+    return 0;
+}
+
+void NonceLease::close() {
+    if(fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+int NonceLease::next(uint64_t *nonce) {
+    while(true) {
+        // next_nonce only grows, and a new lease always starts at or after the end of the last,
+        // so a nonce below lease_end that is still next_nonce at the exchange is ours to use
+        uint64_t n = next_nonce.load();
+        if(n < lease_end.load()) {
+            if(next_nonce.compare_exchange_weak(n, n + 1)) {
+                *nonce = n;
+                return 0;
+            }
+            continue;
+        }
+
+        int ret = renew();
+        if(ret != 0) {
+            return ret;
+        }
+    }
+}
+
+// Takes a new lease, unless another thread already has
+int NonceLease::renew() {
+    std::lock_guard<std::mutex> guard(renew_mutex);
+    if(next_nonce.load() < lease_end.load()) {
+        return 0;
+    }
+    if(fd < 0) {
+        return -EBADF;
+    }
+
+    if(flock(fd, LOCK_EX) != 0) {
+        return -errno;
+    }
+    uint64_t unleased, sequence;
+    int ret = read_record(&unleased, &sequence);
+    if(ret == 0) {
+        ret = write_record(unleased + lease_size, sequence + 1);
+    }
+    flock(fd, LOCK_UN);
+    if(ret != 0) {
+        return ret;
+    }
+
+    // Move next_nonce first, so no thread pairs the old next_nonce with the new end
+    next_nonce.store(unleased);
+    lease_end.store(unleased + lease_size);
+    return 0;
+}
+
+int NonceLease::read_record(uint64_t *unleased, uint64_t *sequence) {
+    struct stat st;
+    if(fstat(fd, &st) != 0) {
+        return -errno;
+    }
+    if(st.st_size == 0) {
+        // A new file; nothing has been leased
+        *unleased = 0;
+        *sequence = 0;
+        return 0;
+    }
+
+    lease_record_t records[2];
+    memset(records, 0, sizeof(records));
+    if(pread(fd, records, sizeof(records), 0) < 0) {
+        return -errno;
+    }
+    int current = -1;
+    for(int i = 0; i < 2; i++) {
+        if(records[i].magic != LEASE_MAGIC || records[i].check != record_check(&records[i])) {
+            continue;
+        }
+        if(current < 0 || records[i].sequence > records[current].sequence) {
+            current = i;
+        }
+    }
+    if(current < 0) {
+        // Starting again from 0 could hand out nonces that were already used
+        return -EIO;
+    }
+    *unleased = records[current].unleased;
+    *sequence = records[current].sequence;
+    return 0;
+}
+
+int NonceLease::write_record(uint64_t unleased, uint64_t sequence) {
+    lease_record_t record;
+    memset(&record, 0, sizeof(record));
+    record.magic = LEASE_MAGIC;
+    record.sequence = sequence;
+    record.unleased = unleased;
+    record.check = record_check(&record);
+
+    off_t offset = (sequence % 2) * sizeof(record);
+    ssize_t written = pwrite(fd, &record, sizeof(record), offset);
+    if(written < 0) {
+        return -errno;
+    }
+    if(written != sizeof(record)) {
+        return -EIO;
+    }
+    // One sync covers the whole lease
+    if(fdatasync(fd) != 0) {
+        return -errno;
+    }
+    return 0;
+}
@@ -0,0 +1,48 @@
+#ifndef NONCE_LEASE_H
+#define NONCE_LEASE_H
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+
+/**
+ * Hands out claim nonces to issuer processes on a server that all sign with the same issuer key,
+ * without any two ever getting the same one (which UniqueNonceDedup relies on).
+ *
+ * The processes share a lease file holding the first nonce not yet leased. A process takes a
+ * range of 'lease_size' nonces at a time under an exclusive lock on the file, and the file is
+ * synced before the range is used, so a crash can only skip nonces, never hand them out again.
+ * Within a process, threads draw nonces from the leased range with atomics alone; the file is
+ * only touched again when the range runs out.
+ *
+ * Nonces come out in increasing order within a process, but interleaved between processes, so
+ * with HighestNonceDedup a claim can be rejected once another process's higher nonce has been
+ * claimed. Those validators need a single issuer process, or a lease_size of 1.
+ *
+ * Not part of the firmware; the directory is left out of the mbed build.
+ */
+class NonceLease {
+public:
+    NonceLease(uint64_t lease_size);
+    ~NonceLease();
+
+    // Opens or creates the lease file. Returns 0, or a negative errno.
+    int open(const char *path);
+    void close();
+
+    // Takes the next nonce. Returns 0, or a negative errno if a new lease could not be recorded.
+    int next(uint64_t *nonce);
+
+private:
+    uint64_t lease_size;
+    int fd;
+    std::atomic<uint64_t> next_nonce;   // Next nonce to hand out
+    std::atomic<uint64_t> lease_end;    // End of the current lease
+    std::mutex renew_mutex;             // Held while taking a new lease
+
+    int renew();
+    int read_record(uint64_t *unleased, uint64_t *sequence);
+    int write_record(uint64_t unleased, uint64_t sequence);
+};
+
+#endif
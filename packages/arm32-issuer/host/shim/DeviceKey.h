@@ -0,0 +1,22 @@
+#ifndef HOST_DEVICEKEY_H
+#define HOST_DEVICEKEY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Derives keys from a per-device secret set in sim.cpp. Not a real KDF; it only has to give
+// the same output for the same salt, and different output for different salts or devices.
+class DeviceKey {
+public:
+    static DeviceKey &get_instance() {
+        static DeviceKey instance;
+        return instance;
+    }
+
+    int generate_derived_key(const unsigned char *salt, size_t salt_size, unsigned char *output, uint16_t ikey_type);
+
+private:
+    DeviceKey() {}
+};
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef HOST_FLASHIAP_H
+#define HOST_FLASHIAP_H
+
+#include <stdint.h>
+
+// Two or more sectors of simulated flash, in sim.cpp; see sim.h for power cuts
+class FlashIAP {
+public:
+    int init();
+    int deinit();
+    int read(void *buffer, uint32_t addr, uint32_t size);
+    int program(const void *buffer, uint32_t addr, uint32_t size);
+    int erase(uint32_t addr, uint32_t size);
+    uint32_t get_page_size() const;
+    uint32_t get_sector_size(uint32_t addr) const;
+    uint8_t get_erase_value() const;
+};
+
+#endif
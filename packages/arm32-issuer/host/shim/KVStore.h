@@ -0,0 +1,6 @@
+#ifndef HOST_KVSTORE_H
+#define HOST_KVSTORE_H
+
+// Only the global KV API is used; see kvstore_global_api.h
+
+#endif
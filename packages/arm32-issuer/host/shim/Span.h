@@ -0,0 +1,43 @@
+#ifndef HOST_SPAN_H
+#define HOST_SPAN_H
+
+#include <stddef.h>
+#include <type_traits>
+
+namespace mbed {
+
+// The parts of mbed::Span the firmware uses: a pointer and a length, convertible to a Span of
+// const elements
+template<typename T>
+class Span {
+public:
+    Span() : _data(NULL), _size(0) {}
+    Span(T *data, size_t size) : _data(data), _size(size) {}
+
+    template<typename U, typename = typename std::enable_if<std::is_convertible<U(*)[], T(*)[]>::value>::type>
+    Span(const Span<U> &other) : _data(other.data()), _size(other.size()) {}
+
+    T *data() const {
+        return _data;
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    bool empty() const {
+        return _size == 0;
+    }
+
+    T &operator[](size_t index) const {
+        return _data[index];
+    }
+
+private:
+    T *_data;
+    size_t _size;
+};
+
+}
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef HOST_ARM_ACLE_H
+#define HOST_ARM_ACLE_H
+
+#include <stdint.h>
+
+static inline uint16_t __rev16(uint16_t value) {
+    return (uint16_t)((value >> 8) | (value << 8));
+}
+
+#endif
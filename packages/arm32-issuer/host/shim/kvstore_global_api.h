@@ -0,0 +1,13 @@
+#ifndef HOST_KVSTORE_GLOBAL_API_H
+#define HOST_KVSTORE_GLOBAL_API_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Backed by the in-memory store in sim.cpp
+int kv_set(const char *full_name_key, const void *buffer, size_t size, uint32_t create_flags);
+int kv_get(const char *full_name_key, void *buffer, size_t buffer_size, size_t *actual_size);
+int kv_remove(const char *full_name_key);
+int kv_reset(const char *kvstore_path);
+
+#endif
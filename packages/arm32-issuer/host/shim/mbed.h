@@ -0,0 +1,113 @@
+#ifndef HOST_MBED_H
+#define HOST_MBED_H
+
+// Just enough of mbed OS to build the firmware's portable modules on a host. Storage, flash and
+// DeviceKey are simulated in sim.cpp; I2C is the ST25 driver's MockI2C.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <functional>
+
+#include "mbed_error.h"
+#include "Span.h"
+#include "FlashIAP.h"
+
+using namespace std::chrono_literals;
+
+typedef int PinName;
+
+static inline uint32_t __REV(uint32_t value) {
+    return __builtin_bswap32(value);
+}
+
+namespace mbed {
+
+template<typename F>
+class Callback;
+
+template<typename R, typename... Args>
+class Callback<R(Args...)> {
+public:
+    Callback() {}
+
+    template<typename F>
+    Callback(F f) : f(f) {}
+
+    R operator()(Args... args) const {
+        return f(args...);
+    }
+
+    explicit operator bool() const {
+        return (bool)f;
+    }
+
+private:
+    std::function<R(Args...)> f;
+};
+
+template<typename T, typename R, typename Arg>
+Callback<R(Arg)> callback(T *obj, R (T::*method)(Arg)) {
+    return Callback<R(Arg)>([obj, method](Arg arg) {
+        return (obj->*method)(arg);
+    });
+}
+
+#define osFlagsErrorTimeout 0xFFFFFFFEU
+
+// Single threaded: waits never block, they return the flags set so far
+class EventFlags {
+public:
+    EventFlags() : flags(0) {}
+
+    uint32_t set(uint32_t set_flags) {
+        flags |= set_flags;
+        return flags;
+    }
+
+    uint32_t clear(uint32_t clear_flags) {
+        uint32_t old = flags;
+        flags &= ~clear_flags;
+        return old;
+    }
+
+    uint32_t wait_any(uint32_t wait_flags) {
+        uint32_t old = flags;
+        flags &= ~wait_flags;
+        return old;
+    }
+
+    // Times out at once if none of 'wait_flags' is set
+    template<typename Duration>
+    uint32_t wait_any_for(uint32_t wait_flags, Duration) {
+        if(!(flags & wait_flags)) {
+            return osFlagsErrorTimeout;
+        }
+        return wait_any(wait_flags);
+    }
+
+private:
+    uint32_t flags;
+};
+
+}
+
+using namespace mbed;
+
+// Sleeps return at once, and are counted
+extern int sim_sleeps;
+
+namespace rtos {
+namespace ThisThread {
+template<typename Duration>
+void sleep_for(Duration) {
+    sim_sleeps++;
+}
+}
+}
+
+using namespace rtos;
+
+#endif
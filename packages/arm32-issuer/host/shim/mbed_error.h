@@ -0,0 +1,15 @@
+#ifndef HOST_MBED_ERROR_H
+#define HOST_MBED_ERROR_H
+
+// The mbed error codes the firmware returns. The values differ from mbed's; only their names
+// and signs matter.
+#define MBED_SUCCESS                        0
+#define MBED_ERROR_FAILED_OPERATION         -257
+#define MBED_ERROR_INITIALIZATION_FAILED    -258
+#define MBED_ERROR_ITEM_NOT_FOUND           -259
+#define MBED_ERROR_NOT_READY                -260
+#define MBED_ERROR_READ_FAILED              -261
+#define MBED_ERROR_UNSUPPORTED              -262
+#define MBED_ERROR_WRITE_FAILED             -263
+
+#endif
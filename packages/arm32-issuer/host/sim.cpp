@@ -0,0 +1,188 @@
+#include "sim.h"
+#include "mbed.h"
+#include "DeviceKey.h"
+#include "kvstore_global_api.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+int sim_sleeps;
+
+// KVStore
+
+static std::map<std::string, std::vector<uint8_t>> kv_items;
+static uint32_t kv_area_used;
+uint32_t sim_kv_sets;
+uint64_t sim_flash_ns;
+
+void sim_kv_clear() {
+    kv_items.clear();
+    kv_area_used = 0;
+}
+
+static uint32_t kv_record_size(const std::string &key, size_t size) {
+    return SIM_KV_RECORD_HEADER + key.size() + size;
+}
+
+// Appends a record to the active TDBStore area, garbage collecting first if it is full
+static void kv_append(const std::string &key, size_t size) {
+    uint32_t record = kv_record_size(key, size);
+    if(kv_area_used + record > SIM_KV_AREA_SIZE) {
+        kv_area_used = 0;
+        for(auto &item : kv_items) {
+            if(item.first != key) {
+                kv_area_used += kv_record_size(item.first, item.second.size());
+            }
+        }
+        sim_flash_ns += SIM_FLASH_ERASE_NS + (uint64_t)kv_area_used * SIM_FLASH_PROGRAM_NS;
+    }
+    kv_area_used += record;
+    sim_flash_ns += (uint64_t)record * SIM_FLASH_PROGRAM_NS;
+}
+
+int kv_set(const char *full_name_key, const void *buffer, size_t size, uint32_t create_flags) {
+    sim_kv_sets++;
+    kv_append(full_name_key, size);
+    const uint8_t *data = (const uint8_t*)buffer;
+    kv_items[full_name_key] = std::vector<uint8_t>(data, data + size);
+    return MBED_SUCCESS;
+}
+
+int kv_get(const char *full_name_key, void *buffer, size_t buffer_size, size_t *actual_size) {
+    auto item = kv_items.find(full_name_key);
+    if(item == kv_items.end()) {
+        return MBED_ERROR_ITEM_NOT_FOUND;
+    }
+    size_t size = item->second.size() < buffer_size ? item->second.size() : buffer_size;
+    memcpy(buffer, item->second.data(), size);
+    *actual_size = size;
+    return MBED_SUCCESS;
+}
+
+int kv_remove(const char *full_name_key) {
+    if(!kv_items.erase(full_name_key)) {
+        return MBED_ERROR_ITEM_NOT_FOUND;
+    }
+    kv_append(full_name_key, 0);
+    return MBED_SUCCESS;
+}
+
+int kv_reset(const char *kvstore_path) {
+    std::string prefix = std::string(kvstore_path) + "/";
+    for(auto item = kv_items.begin(); item != kv_items.end();) {
+        if(item->first.compare(0, prefix.size(), prefix) == 0) {
+            item = kv_items.erase(item);
+        } else {
+            item++;
+        }
+    }
+    // TDBStore starts again in an erased area
+    kv_area_used = 0;
+    for(auto &item : kv_items) {
+        kv_area_used += kv_record_size(item.first, item.second.size());
+    }
+    sim_flash_ns += SIM_FLASH_ERASE_NS + (uint64_t)kv_area_used * SIM_FLASH_PROGRAM_NS;
+    return MBED_SUCCESS;
+}
+
+// FlashIAP
+
+uint8_t sim_flash[SIM_FLASH_SECTOR_SIZE * SIM_FLASH_SECTORS];
+int sim_flash_budget = -1;
+uint32_t sim_flash_programs;
+uint32_t sim_flash_erases;
+
+static uint8_t *flash_at(uint32_t addr, uint32_t size) {
+    if(addr < SIM_FLASH_BASE || addr + size > SIM_FLASH_BASE + sizeof(sim_flash)) {
+        return NULL;
+    }
+    return &sim_flash[addr - SIM_FLASH_BASE];
+}
+
+static void spend_budget() {
+    if(sim_flash_budget == 0) {
+        throw sim_power_cut();
+    }
+    if(sim_flash_budget > 0) {
+        sim_flash_budget--;
+    }
+}
+
+int FlashIAP::init() {
+    return 0;
+}
+
+int FlashIAP::deinit() {
+    return 0;
+}
+
+int FlashIAP::read(void *buffer, uint32_t addr, uint32_t size) {
+    uint8_t *cells = flash_at(addr, size);
+    if(cells == NULL) {
+        return -1;
+    }
+    memcpy(buffer, cells, size);
+    return 0;
+}
+
+// Programming can only clear bits, as on real flash
+int FlashIAP::program(const void *buffer, uint32_t addr, uint32_t size) {
+    uint8_t *cells = flash_at(addr, size);
+    if(cells == NULL) {
+        return -1;
+    }
+    sim_flash_programs++;
+    for(uint32_t i = 0; i < size; i++) {
+        spend_budget();
+        cells[i] &= ((const uint8_t*)buffer)[i];
+        sim_flash_ns += SIM_FLASH_PROGRAM_NS;
+    }
+    return 0;
+}
+
+int FlashIAP::erase(uint32_t addr, uint32_t size) {
+    uint8_t *cells = flash_at(addr, size);
+    if(cells == NULL || (addr - SIM_FLASH_BASE) % SIM_FLASH_SECTOR_SIZE != 0 || size % SIM_FLASH_SECTOR_SIZE != 0) {
+        return -1;
+    }
+    sim_flash_erases++;
+    spend_budget();
+    sim_flash_ns += SIM_FLASH_ERASE_NS;
+    memset(cells, get_erase_value(), size);
+    return 0;
+}
+
+uint32_t FlashIAP::get_page_size() const {
+    return 1;
+}
+
+uint32_t FlashIAP::get_sector_size(uint32_t addr) const {
+    return SIM_FLASH_SECTOR_SIZE;
+}
+
+uint8_t FlashIAP::get_erase_value() const {
+    return 0xFF;
+}
+
+// DeviceKey
+
+static uint8_t device_id;
+
+void sim_set_device(uint8_t id) {
+    device_id = id;
+}
+
+int DeviceKey::generate_derived_key(const unsigned char *salt, size_t salt_size, unsigned char *output, uint16_t ikey_type) {
+    // FNV-1a over the device and salt, then one more round per output byte
+    uint32_t hash = 0x811C9DC5;
+    hash = (hash ^ device_id) * 0x01000193;
+    for(size_t i = 0; i < salt_size; i++) {
+        hash = (hash ^ salt[i]) * 0x01000193;
+    }
+    for(uint16_t i = 0; i < ikey_type; i++) {
+        hash = (hash ^ i) * 0x01000193;
+        output[i] = hash >> 24;
+    }
+    return MBED_SUCCESS;
+}
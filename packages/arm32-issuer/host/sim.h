@@ -0,0 +1,43 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+
+// Controls for the simulated KVStore, flash and DeviceKey behind the mbed shim (sim.cpp)
+
+// Flash covers the nonce journal's two sectors; host builds set the journal address to match
+#define SIM_FLASH_BASE          0x08060000
+#define SIM_FLASH_SECTOR_SIZE   256
+#define SIM_FLASH_SECTORS       2
+
+extern uint8_t sim_flash[SIM_FLASH_SECTOR_SIZE * SIM_FLASH_SECTORS];
+
+// Bytes that can still be programmed (an erase counts as one) before the power fails, which
+// throws sim_power_cut out of the FlashIAP call; -1 for no limit
+extern int sim_flash_budget;
+extern uint32_t sim_flash_programs;
+extern uint32_t sim_flash_erases;
+
+struct sim_power_cut {};
+
+// Device time spent in flash, from the typical STM32F411 figures: 16 us to program a byte, and
+// 250 ms to erase a sector (as for its 16 KB ones). The simulated KVStore spends it as TDBStore
+// would: each kv_set or kv_remove appends a record to the active area, and once that is full,
+// garbage collection erases the other area and copies the live records to it.
+#define SIM_FLASH_PROGRAM_NS    16000
+#define SIM_FLASH_ERASE_NS      250000000
+#define SIM_KV_AREA_SIZE        16384
+#define SIM_KV_RECORD_HEADER    24
+
+extern uint64_t sim_flash_ns;
+
+// kv_set calls so far
+extern uint32_t sim_kv_sets;
+
+// Empties the store, as on a new device
+void sim_kv_clear();
+
+// Selects the device whose secret DeviceKey derives from
+void sim_set_device(uint8_t id);
+
+#endif
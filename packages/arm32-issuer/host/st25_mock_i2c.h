@@ -0,0 +1,219 @@
+#ifndef ST25_MOCK_I2C_H
+#define ST25_MOCK_I2C_H
+
+#import "mbed.h"
+
+// Stands in for mbed's I2C in the ST25 driver when built with ST25_MOCK_I2C, so the driver can
+// run on a host without hardware. It models an ST25DV: user memory and dynamic registers at
+// ADDRESS_USER_MEM, system registers at ADDRESS_REGISTERS, the fast transfer mailbox, and a
+// device that NACKs for a while after every write that programs the EEPROM.
+// rf_read_message plays the part of a reader fetching the mailbox, and rf_session one holding an
+// RF session open, during which the EEPROM NACKs I2C as on the ST25DV. With lose_completions set,
+// transfers never call back, as with a bus that has locked up.
+
+#ifndef I2C_EVENT_ALL
+#define I2C_EVENT_ERROR               (1 << 1)
+#define I2C_EVENT_ERROR_NO_SLAVE      (1 << 2)
+#define I2C_EVENT_TRANSFER_COMPLETE   (1 << 3)
+#define I2C_EVENT_TRANSFER_EARLY_NACK (1 << 4)
+#define I2C_EVENT_ALL                 (I2C_EVENT_ERROR | I2C_EVENT_TRANSFER_COMPLETE | \
+                                       I2C_EVENT_ERROR_NO_SLAVE | I2C_EVENT_TRANSFER_EARLY_NACK)
+#endif
+
+#define MOCK_I2C_USER_MEM       0xA6
+#define MOCK_I2C_REGISTERS      0xAE
+#define MOCK_I2C_DYNAMIC_BASE   0x2000
+#define MOCK_I2C_RF_MNGT        0x03
+#define MOCK_I2C_IT_STS         0x05
+#define MOCK_I2C_MB_CTRL        0x06
+#define MOCK_I2C_MB_LEN         0x07
+#define MOCK_I2C_MAILBOX        0x08
+#define MOCK_I2C_MAILBOX_SIZE   256
+
+class MockI2C {
+public:
+    uint8_t user_mem[8192];
+    uint8_t registers[0x0A00];
+    uint8_t dynamic[MOCK_I2C_MAILBOX + MOCK_I2C_MAILBOX_SIZE];
+    int user_size;              // Bytes of user memory, set by set_memory_size
+    int program_polls;          // Transactions NACKed after each EEPROM write
+    uint32_t transactions;      // Transactions seen, including NACKed ones
+    int rf_session;             // Transactions left in an RF session; putting RF to sleep ends it
+    uint32_t rf_nacks;          // EEPROM accesses NACKed for an RF session
+    bool lose_completions;
+    uint32_t aborts;            // abort_transfer calls
+
+    MockI2C(PinName sda, PinName scl) : program_polls(2), transactions(0), rf_session(0), rf_nacks(0),
+            lose_completions(false), aborts(0), busy(0), pointer(0) {
+        memset(user_mem, 0, sizeof(user_mem));
+        memset(registers, 0, sizeof(registers));
+        memset(dynamic, 0, sizeof(dynamic));
+        set_memory_size(512);
+    }
+
+    // Sets the MEM_SIZE and BLK_SIZE registers for a part of 'bytes' bytes
+    void set_memory_size(int bytes) {
+        user_size = bytes < (int)sizeof(user_mem) ? bytes : sizeof(user_mem);
+        uint16_t blocks = bytes / 4 - 1;
+        registers[0x14] = blocks & 0xFF;
+        registers[0x15] = blocks >> 8;
+        registers[0x16] = 3;
+    }
+
+    int write(int address, const char *data, int length, bool repeated = false) {
+        transactions++;
+        bool in_session = rf_tick();
+        if(busy > 0) {
+            busy--;
+            return -1;
+        }
+        if(length < 2) {
+            return 0;
+        }
+        pointer = ((uint8_t)data[0] << 8) | (uint8_t)data[1];
+        if(length == 2) {
+            return 0;
+        }
+        if(in_session && eeprom(address)) {
+            rf_nacks++;
+            return -1;
+        }
+        if(address == MOCK_I2C_USER_MEM && pointer >= MOCK_I2C_DYNAMIC_BASE) {
+            return write_dynamic(pointer - MOCK_I2C_DYNAMIC_BASE, (const uint8_t*)data + 2, length - 2);
+        }
+        for(int i = 2; i < length; i++) {
+            uint8_t *cell = locate(address, pointer + i - 2);
+            if(cell == NULL) {
+                return -1;
+            }
+            *cell = data[i];
+        }
+        if(address == MOCK_I2C_REGISTERS || pointer < MOCK_I2C_DYNAMIC_BASE) {
+            busy = program_polls;
+        }
+        return 0;
+    }
+
+    int read(int address, char *data, int length, bool repeated = false) {
+        transactions++;
+        bool in_session = rf_tick();
+        if(busy > 0) {
+            busy--;
+            return -1;
+        }
+        if(in_session && eeprom(address)) {
+            rf_nacks++;
+            return -1;
+        }
+        for(int i = 0; i < length; i++) {
+            uint8_t *cell = locate(address, pointer + i);
+            if(cell == NULL) {
+                return -1;
+            }
+            data[i] = *cell;
+            if(cell == &dynamic[MOCK_I2C_IT_STS]) {
+                // Interrupt status clears when read
+                *cell = 0;
+            }
+        }
+        return 0;
+    }
+
+    // Fetches the mailbox as an RF reader would, returning the message length, or -1 if there
+    // is no message from the host
+    int rf_read_message(uint8_t *out) {
+        if(!(dynamic[MOCK_I2C_MB_CTRL] & 0x01) || !(dynamic[MOCK_I2C_MB_CTRL] & 0x02)) {
+            return -1;
+        }
+        int len = dynamic[MOCK_I2C_MB_LEN] + 1;
+        memcpy(out, &dynamic[MOCK_I2C_MAILBOX], len);
+        dynamic[MOCK_I2C_MB_CTRL] &= ~0x02;
+        dynamic[MOCK_I2C_IT_STS] |= 0x40;
+        return len;
+    }
+
+    // Completes at once, calling 'callback' before returning
+    int transfer(int address, const char *tx_buffer, int tx_length, char *rx_buffer, int rx_length,
+                 const Callback<void(int)> &callback, int event = I2C_EVENT_TRANSFER_COMPLETE,
+                 bool repeated = false) {
+        int ret = 0;
+        if(tx_length > 0) {
+            ret = write(address, tx_buffer, tx_length, rx_length > 0);
+        }
+        if(ret == 0 && rx_length > 0) {
+            ret = read(address, rx_buffer, rx_length);
+        }
+        int result = ret == 0 ? I2C_EVENT_TRANSFER_COMPLETE : I2C_EVENT_ERROR_NO_SLAVE;
+        if(callback && (result & event) && !lose_completions) {
+            callback(result);
+        }
+        return 0;
+    }
+
+    void abort_transfer() {
+        aborts++;
+    }
+
+private:
+    int busy;
+    uint16_t pointer;
+
+    // Counts a transaction against the RF session, returning whether it is still open
+    bool rf_tick() {
+        if(rf_session <= 0) {
+            return false;
+        }
+        rf_session--;
+        return true;
+    }
+
+    bool eeprom(int address) {
+        return address == MOCK_I2C_REGISTERS || pointer < MOCK_I2C_DYNAMIC_BASE;
+    }
+
+    // Dynamic registers are volatile, and MB_CTRL and the mailbox behave as on the ST25DV
+    int write_dynamic(uint16_t offset, const uint8_t *data, int length) {
+        if(offset >= MOCK_I2C_MAILBOX) {
+            // A message must fill the mailbox from the start, in one transaction, and can't
+            // replace one that is waiting to be read
+            uint8_t ctrl = dynamic[MOCK_I2C_MB_CTRL];
+            if(offset != MOCK_I2C_MAILBOX || length > MOCK_I2C_MAILBOX_SIZE ||
+                    !(ctrl & 0x01) || (ctrl & 0x06)) {
+                return -1;
+            }
+            memcpy(&dynamic[MOCK_I2C_MAILBOX], data, length);
+            dynamic[MOCK_I2C_MB_LEN] = length - 1;
+            dynamic[MOCK_I2C_MB_CTRL] |= 0x02;
+            return 0;
+        }
+        for(int i = 0; i < length; i++) {
+            if(offset + i == MOCK_I2C_MB_CTRL) {
+                // Only MB_EN is writable; clearing it empties the mailbox
+                dynamic[MOCK_I2C_MB_CTRL] = data[i] & 0x01;
+                dynamic[MOCK_I2C_MB_LEN] = 0;
+            } else if(offset + i < MOCK_I2C_MAILBOX) {
+                dynamic[offset + i] = data[i];
+                if(offset + i == MOCK_I2C_RF_MNGT && (data[i] & 0x03)) {
+                    // RF disabled or asleep: the reader loses the tag
+                    rf_session = 0;
+                }
+            } else {
+                return -1;
+            }
+        }
+        return 0;
+    }
+
+    uint8_t *locate(int address, uint32_t addr) {
+        if(address == MOCK_I2C_REGISTERS) {
+            return addr < sizeof(registers) ? &registers[addr] : NULL;
+        }
+        if(addr >= MOCK_I2C_DYNAMIC_BASE) {
+            addr -= MOCK_I2C_DYNAMIC_BASE;
+            return addr < sizeof(dynamic) ? &dynamic[addr] : NULL;
+        }
+        return addr < (uint32_t)user_size ? &user_mem[addr] : NULL;
+    }
+};
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+
+// Each test is a program that exits with the number of failed checks
+
+static int test_failures = 0;
+
+#define CHECK(cond) do { \
+        if(!(cond)) { \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            test_failures++; \
+        } \
+    } while(0)
+
+#define TEST_RESULT() (printf("%s: %s\n", __FILE__, test_failures ? "FAILED" : "ok"), test_failures)
+
+#endif
@@ -0,0 +1,72 @@
+// The boot path: the cached issuer address must be the one the key gives, even if the cache is
+// damaged, and the recorded boot times must add up and survive a store reset.
+
+#include "test.h"
+#include "sim.h"
+#include "mbed_error.h"
+#include "storage.h"
+#include "config.h"
+#include "kvstore_global_api.h"
+
+#include <string.h>
+
+int main() {
+    sim_kv_clear();
+    privkey_t key, cached_key;
+    address_t address, cached;
+    CHECK(get_issuer_key(key) == MBED_SUCCESS);
+    CHECK(get_issuer_address(address) == MBED_SUCCESS);
+
+    // The first boot computes the address and caches it; the next reads it back
+    uint32_t sets = sim_kv_sets;
+    CHECK(load_issuer(cached_key, cached) == MBED_SUCCESS);
+    CHECK(memcmp(key, cached_key, sizeof(key)) == 0);
+    CHECK(memcmp(address, cached, sizeof(address)) == 0);
+    CHECK(sim_kv_sets == sets + 1);
+    memset(cached, 0, sizeof(cached));
+    CHECK(load_issuer(cached_key, cached) == MBED_SUCCESS);
+    CHECK(memcmp(address, cached, sizeof(address)) == 0);
+    CHECK(sim_kv_sets == sets + 1);
+
+    // A damaged cache is not believed, and is rewritten
+    uint8_t cache[sizeof(address_t) + sizeof(hash_t)];
+    size_t cache_size;
+    CHECK(kv_get(ISSUER_CACHE_KEY_PATH, cache, sizeof(cache), &cache_size) == MBED_SUCCESS);
+    CHECK(cache_size == sizeof(cache));
+    cache[3] ^= 1;
+    kv_set(ISSUER_CACHE_KEY_PATH, cache, sizeof(cache), 0);
+    CHECK(load_issuer(cached_key, cached) == MBED_SUCCESS);
+    CHECK(memcmp(address, cached, sizeof(address)) == 0);
+    CHECK(kv_get(ISSUER_CACHE_KEY_PATH, cache, sizeof(cache), &cache_size) == MBED_SUCCESS);
+    CHECK(memcmp(cache, address, sizeof(address)) == 0);
+
+    // So is one for another device's key
+    sim_set_device(2);
+    CHECK(load_issuer(cached_key, cached) == MBED_SUCCESS);
+    CHECK(memcmp(address, cached, sizeof(address)) != 0);
+    CHECK(get_issuer_address(address) == MBED_SUCCESS);
+    CHECK(memcmp(address, cached, sizeof(address)) == 0);
+
+    // Boot times
+    boot_stats_t stats;
+    CHECK(record_boot_time(40, 300, &stats) == MBED_SUCCESS);
+    CHECK(stats.boots == 1 && stats.last_ms == 300 && stats.best_ms == 300 && stats.worst_ms == 300);
+    CHECK(record_boot_time(10, 120, &stats) == MBED_SUCCESS);
+    CHECK(record_boot_time(20, 200, &stats) == MBED_SUCCESS);
+    CHECK(stats.boots == 3);
+    CHECK(stats.last_init_ms == 20 && stats.last_ms == 200);
+    CHECK(stats.best_ms == 120 && stats.worst_ms == 300);
+
+    // A store reset keeps them
+    CHECK(reset_store() == MBED_SUCCESS);
+    CHECK(record_boot_time(20, 150, &stats) == MBED_SUCCESS);
+    CHECK(stats.boots == 4 && stats.best_ms == 120 && stats.worst_ms == 300);
+
+    // Stats of another size, as from another version, start again
+    uint32_t old_stats[2] = {9, 9};
+    kv_set(BOOT_STATS_KEY_PATH, old_stats, sizeof(old_stats), 0);
+    CHECK(record_boot_time(20, 500, &stats) == MBED_SUCCESS);
+    CHECK(stats.boots == 1 && stats.best_ms == 500 && stats.worst_ms == 500);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,57 @@
+// Claim seeds must not change for a nonce, including across a store reset and a reboot, or a
+// claim code could come out again with another claimant.
+
+#include "test.h"
+#include "sim.h"
+#include "mbed_error.h"
+#include "claim_seed.h"
+#include "storage.h"
+#include "config.h"
+#include "kvstore_global_api.h"
+
+#include <string.h>
+
+extern uint32_t next_nonce;
+extern bool seed_ready;
+
+// Forgets what the firmware keeps in RAM
+static void reboot() {
+    next_nonce = 0xffffffff;
+    seed_ready = false;
+}
+
+int main() {
+    const uint32_t nonces[] = {0, 5, 999, 1000, 1500, 70000};
+    const int count = sizeof(nonces) / sizeof(nonces[0]);
+    seed_t before[count], after;
+
+    // A device that handed out nonces 0-999 before PRF seeds
+    sim_kv_clear();
+    uint32_t stored = 1000;
+    kv_set(NEXT_NONCE_KEY_PATH, &stored, sizeof(stored), 0);
+    reboot();
+    CHECK(claim_seed_init() == MBED_SUCCESS);
+    for(int i = 0; i < count; i++) {
+        CHECK(claim_seed(nonces[i], before[i]) == MBED_SUCCESS);
+    }
+
+    // The PRF only takes over from the recorded nonce
+    uint32_t prf_start;
+    CHECK(get_seed_prf_start(&prf_start) == MBED_SUCCESS);
+    CHECK(prf_start == 1000);
+
+    // A store reset clears the stored nonce, but must not move the cutover
+    CHECK(reset_store() == MBED_SUCCESS);
+    reboot();
+    CHECK(claim_seed_init() == MBED_SUCCESS);
+    for(int i = 0; i < count; i++) {
+        CHECK(claim_seed(nonces[i], after) == MBED_SUCCESS);
+        CHECK(memcmp(before[i], after, SEED_LENGTH) == 0);
+    }
+
+    // Seeds are not ready until initialised after a reboot
+    reboot();
+    CHECK(claim_seed(5, after) == MBED_ERROR_NOT_READY);
+
+    return TEST_RESULT();
+}
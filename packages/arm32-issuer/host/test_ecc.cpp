@@ -0,0 +1,115 @@
+// ECDH and ECDSA verification on secp256k1, built as test_ecc (comb and GLV), test_ecc-glv (GLV
+// for the generator too) and test_ecc-ladder (the Montgomery ladder throughout). The known
+// answers come from affine arithmetic in Python, so they check each build against something other
+// than the others.
+
+#include "test.h"
+#include "uECC.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *const PRIVKEY = "1111111111111111111111111111111111111111111111111111111111badcfe";
+static const char *const PUBKEY =
+    "d276bda8550835cc141ba1e65500cc73ca298a033d785ce097b1a048ca69cfc1"
+    "20fc0ceb64bb93d9312544be10ccd61dc5e3a668506b26b989c40653a90bb938";
+static const char *const PEER_PRIVKEY = "5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a5a";
+static const char *const PEER_PUBKEY =
+    "9c5530e4385ebc41cdaf8257edf9a2baaf8506a4099103211e6ed7382103ed67"
+    "3c959f0354f61f639ef43b967af7d75c9e9eabb44064949b43a55189ab4ce722";
+static const char *const SHARED_SECRET = "15054d48c8932e6a2cf2d282e36002cc5e6428a0261d898aaa5a04367c557ad9";
+
+// PRIVKEY's signature of HASH, with a fixed k
+static const char *const HASH = "9c22ff5f21f0b81b113e63f7db6da94fedef11b2119b4088b89664fb9a3cb658";
+static const char *const SIGNATURE =
+    "bb50e2d89a4ed70663d080659fe0ad4b9bc3e06c17a227433966cb59ceee020d"
+    "5461906f8e28392775c50f74e98296da07bddcfeae561be49ad1da08c0437059";
+
+static void from_hex(const char *hex, uint8_t *bytes, size_t size) {
+    for(size_t i = 0; i < size; i++) {
+        char byte[3] = {hex[2 * i], hex[2 * i + 1], 0};
+        bytes[i] = (uint8_t)strtoul(byte, NULL, 16);
+    }
+}
+
+static void test_known_answers(uECC_Curve curve) {
+    uint8_t privkey[32], peer_privkey[32], expected[64], pubkey[64], peer_pubkey[64];
+    from_hex(PRIVKEY, privkey, 32);
+    from_hex(PEER_PRIVKEY, peer_privkey, 32);
+
+    CHECK(uECC_compute_public_key(privkey, pubkey, curve));
+    from_hex(PUBKEY, expected, 64);
+    CHECK(memcmp(pubkey, expected, 64) == 0);
+    CHECK(uECC_compute_public_key(peer_privkey, peer_pubkey, curve));
+    from_hex(PEER_PUBKEY, expected, 64);
+    CHECK(memcmp(peer_pubkey, expected, 64) == 0);
+
+    // Both sides arrive at the same secret, and it is the right one
+    uint8_t secret[32], peer_secret[32];
+    CHECK(uECC_shared_secret(peer_pubkey, privkey, secret, curve));
+    CHECK(uECC_shared_secret(pubkey, peer_privkey, peer_secret, curve));
+    from_hex(SHARED_SECRET, expected, 32);
+    CHECK(memcmp(secret, expected, 32) == 0);
+    CHECK(memcmp(peer_secret, expected, 32) == 0);
+
+    uint8_t hash[32], sig[64], bad[64];
+    from_hex(HASH, hash, 32);
+    from_hex(SIGNATURE, sig, 64);
+    CHECK(uECC_verify(pubkey, hash, 32, sig, curve));
+
+    // The wrong key, the wrong hash, or a changed r or s must not verify
+    CHECK(!uECC_verify(peer_pubkey, hash, 32, sig, curve));
+    hash[31] ^= 1;
+    CHECK(!uECC_verify(pubkey, hash, 32, sig, curve));
+    hash[31] ^= 1;
+    for(int i = 0; i < 64; i += 9) {
+        memcpy(bad, sig, 64);
+        bad[i] ^= 0x40;
+        CHECK(!uECC_verify(pubkey, hash, 32, bad, curve));
+    }
+    // Nor may r or s of 0
+    memcpy(bad, sig, 64);
+    memset(bad, 0, 32);
+    CHECK(!uECC_verify(pubkey, hash, 32, bad, curve));
+    memcpy(bad, sig, 64);
+    memset(bad + 32, 0, 32);
+    CHECK(!uECC_verify(pubkey, hash, 32, bad, curve));
+}
+
+// Keys of all sizes, signed and checked against each other
+static void test_round_trips(uECC_Curve curve) {
+    for(int i = 0; i < 32; i++) {
+        uint8_t privkey[32], peer_privkey[32], pubkey[64], peer_pubkey[64];
+        memset(privkey, 0, 32);
+        memset(peer_privkey, 0, 32);
+        // Leading zero bytes, up to a full-size key
+        for(int j = i; j < 32; j++) {
+            privkey[j] = (uint8_t)(j * 37 + i * 11 + 1);
+            peer_privkey[j] = (uint8_t)(j * 53 + i * 7 + 3);
+        }
+        privkey[0] &= 0x7F;
+        CHECK(uECC_compute_public_key(privkey, pubkey, curve));
+        CHECK(uECC_compute_public_key(peer_privkey, peer_pubkey, curve));
+
+        uint8_t secret[32], peer_secret[32];
+        CHECK(uECC_shared_secret(peer_pubkey, privkey, secret, curve));
+        CHECK(uECC_shared_secret(pubkey, peer_privkey, peer_secret, curve));
+        CHECK(memcmp(secret, peer_secret, 32) == 0);
+
+        uint8_t hash[32], sig[64];
+        memset(hash, i * 5 + 1, sizeof(hash));
+        CHECK(uECC_sign(privkey, hash, 32, sig, curve));
+        // uECC_sign gives s low, with the parity of R's y in its top bit (EIP 2098)
+        sig[32] &= 0x7F;
+        CHECK(uECC_verify(pubkey, hash, 32, sig, curve));
+        CHECK(!uECC_verify(peer_pubkey, hash, 32, sig, curve));
+    }
+}
+
+int main() {
+    uECC_Curve curve = uECC_secp256k1();
+    test_known_answers(curve);
+    test_round_trips(curve);
+    return TEST_RESULT();
+}
@@ -0,0 +1,223 @@
+// Known answers for secp256k1 field multiplication and squaring modulo p, and for public keys,
+// built as test_field (the backend the build picks: the UMAAL routine with the fused reduction
+// on ARMv6 and later, the x86-64 one on x86-64 hosts), test_field-portable (the generic C path
+// with 64-bit words) and test_field-w32 (the generic C path with 32-bit words and the lazy 10x26
+// field). The inputs include 0, p - 1 and values in [p, 2^256), whose products carry the most
+// through the reduction. For a 32-bit ARM build under qemu-arm, see the Makefile.
+
+#include "test.h"
+#include "uECC.h"
+#include "uECC_vli.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_WORDS (32 / sizeof(uECC_word_t))
+
+// left, right, left * right mod p; big-endian hex
+static const char *const MULT_VECTORS[][3] = {
+    {"0000000000000000000000000000000000000000000000000000000000000000",
+     "0000000000000000000000000000000000000000000000000000000000000000",
+     "0000000000000000000000000000000000000000000000000000000000000000"},
+    {"0000000000000000000000000000000000000000000000000000000000000000",
+     "0000000000000000000000000000000000000000000000000000000000000001",
+     "0000000000000000000000000000000000000000000000000000000000000000"},
+    {"0000000000000000000000000000000000000000000000000000000000000000",
+     "0000000000000000000000000000000000000000000000000000000000000002",
+     "0000000000000000000000000000000000000000000000000000000000000000"},
+    {"0000000000000000000000000000000000000000000000000000000000000000",
+     "fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2e",
+     "0000000000000000000000000000000000000000000000000000000000000000"},
+    {"0000000000000000000000000000000000000000000000000000000000000000",
+     "fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2d",
+     "0000000000000000000000000000000000000000000000000000000000000000"},
+    {"0000000000000000000000000000000000000000000000000000000000000000",
+     "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff",
+     "0000000000000000000000000000000000000000000000000000000000000000"},
+    {"0000000000000000000000000000000000000000000000000000000000000001",
+     "0000000000000000000000000000000000000000000000000000000000000001",
+     "0000000000000000000000000000000000000000000000000000000000000001"},
+    {"0000000000000000000000000000000000000000000000000000000000000001",
+     "0000000000000000000000000000000000000000000000000000000000000002",
+     "0000000000000000000000000000000000000000000000000000000000000002"},
+    {"0000000000000000000000000000000000000000000000000000000000000001",
+     "fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2e",
+     "fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2e"},
+    {"0000000000000000000000000000000000000000000000000000000000000001",
+     "fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2d",
+     "fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2d"},
+    {"0000000000000000000000000000000000000000000000000000000000000001",
+     "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff",
+     "00000000000000000000000000000000000000000000000000000001000003d0"},
+    {"0000000000000000000000000000000000000000000000000000000000000002",
+     "0000000000000000000000000000000000000000000000000000000000000002",
+     "0000000000000000000000000000000000000000000000000000000000000004"},
+    {"0000000000000000000000000000000000000000000000000000000000000002",
+     "fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2e",
+     "fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2d"},
+    {"0000000000000000000000000000000000000000000000000000000000000002",
+     "fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2d",
+     "fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2b"},
+    {"0000000000000000000000000000000000000000000000000000000000000002",
+     "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff",
+     "00000000000000000000000000000000000000000000000000000002000007a0"},
+    {"fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2e",
+     "fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2e",
+     "0000000000000000000000000000000000000000000000000000000000000001"},
+    {"fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2e",
+     "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff",
+     "fffffffffffffffffffffffffffffffffffffffffffffffffffffffdfffff85f"},
+    {"fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2d",
+     "fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2e",
+     "0000000000000000000000000000000000000000000000000000000000000002"},
+    {"fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2d",
+     "fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2d",
+     "0000000000000000000000000000000000000000000000000000000000000004"},
+    {"fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2d",
+     "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff",
+     "fffffffffffffffffffffffffffffffffffffffffffffffffffffffcfffff48f"},
+    {"ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff",
+     "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff",
+     "000000000000000000000000000000000000000000000001000007a0000e8900"},
+    {"fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2f",
+     "fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc30",
+     "0000000000000000000000000000000000000000000000000000000000000000"},
+    {"8000000000000000000000000000000000000000000000000000000000000000",
+     "8000000000000000000000000000000000000000000000000000000000000000",
+     "400000000000000000000000000000000000000000000000400001e84003a334"},
+    {"00000000000000000000000000000000000000000000000000000001000003d1",
+     "00000000ffffffffffffffffffffffffffffffffffffffffffffffffffffffff",
+     "000003d100000000000000000000000000000000000000000000000000000000"},
+    {"5555555555555555555555555555555555555555555555555555555555555555",
+     "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff",
+     "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaab0000028a0004d5ca"},
+    {"fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2f",
+     "fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2f",
+     "0000000000000000000000000000000000000000000000000000000000000000"},
+    {"949a5021c170b2a37b89a060c2fe2e6242e53a9f7eb18df5c6b09bde93742d10",
+     "b8f8e02a0abe57f7313ad1e8b41edea227261cd02a14bdb6f252cc461ee49170",
+     "700858115969808b4565c0b613111aea47d6ded542a88ddf2d9948b2fee75776"},
+    {"04c19fa1d12cc21ccb960926be8e14871102759ba94d58b9ebafcaf1fcee15f6",
+     "7459bfd733a4bd88d29c07ec6b063adfdc0c545928d7a2db87ba574c72f6d813",
+     "528eae97f7a78aab5c154fbb9bd136ce38db92ac1011e491289a163d5abb6780"},
+    {"d321309153232f80639c20133166f02819071c075db8796215dce46c287f1214",
+     "20c8f4d1742c08ff8e7b69e22db21c9e65b45b2f43871498e00f3c75c73fdfa6",
+     "4831d70a276fe6138b2ad5d2d4d92d47af8b3edf86a59f440110653b7c77bd8e"},
+    {"3c25cd7c84c3041826e1411efc8781cfc8c19b3afbec92d4385101ed9986a78a",
+     "d3252f05a8cf8644221c2d5b8236e582aa843d82f91a1bdc8d6aef6d25b4ea59",
+     "8fc69256b9e74a0568a2f82cc36493a9836c920a3c91d92a40e6ad870409cce7"},
+    {"e70f0b695147c0fc62f699ef56aa3412e560c501ca26d32e39a737e605508fca",
+     "ce776b00a285124e371454ae20c3568c4767f8b150b59c5a9a3bf599dbcc31d0",
+     "f15289ca549d7efc9e065862f17e3c7be57f679108d2292a99bd8146d0cf6915"},
+    {"b25bc22109351b0531e3233f2c6cd6f20353bd6552490a80e758b6676ed914e5",
+     "9019e70316cf0f0ac36a7e6a7443a601491bd399e79ec87932f819914ccc6772",
+     "d0b91fda0a7575282b1409fa251c45bba4cbc3303796b92b9fe7c66e9a340bc6"},
+    {"505ed17b0060b2f1b90304ac0b714ff922863ce164509164bda78c1e7420ccca",
+     "ec6da16997ae29d0bcd999c20fbfa30f323db83ac1bc83ef89082c19c8e4ac64",
+     "7ed162c6fc1962b24fa3eacf323a954b7e9db28ca92c84eb7fad31f68815f414"},
+    {"5a972fa5d7ba4c17ce03f4adb6ea00fdd820ef3c86330cc726e255d3856651cb",
+     "e6f9635ba131ea9cb34f0884c5b368a2d64cb9ccb6e007f68c65689cef9ef3de",
+     "a1ab05c6e3723c11128d9affa0bd79cf30031c732a091d646443f54e8a3a8a37"},
+};
+
+// Private key, public key (x | y); big-endian hex
+static const char *const KEY_VECTORS[][2] = {
+    {"0000000000000000000000000000000000000000000000000000000000000001",
+     "79be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798"
+     "483ada7726a3c4655da4fbfc0e1108a8fd17b448a68554199c47d08ffb10d4b8"},
+    {"0000000000000000000000000000000000000000000000000000000000000002",
+     "c6047f9441ed7d6d3045406e95c07cd85c778e4b8cef3ca7abac09b95c709ee5"
+     "1ae168fea63dc339a3c58419466ceaeef7f632653266d0e1236431a950cfe52a"},
+    {"fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364140",
+     "79be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798"
+     "b7c52588d95c3b9aa25b0403f1eef75702e84bb7597aabe663b82f6f04ef2777"},
+    {"1111111111111111111111111111111111111111111111111111111111111111",
+     "4f355bdcb7cc0af728ef3cceb9615d90684bb5b2ca5f859ab0f0b704075871aa"
+     "385b6b1b8ead809ca67454d9683fcf2ba03456d6fe2c4abe2b07f0fbdbb2f1c1"},
+    {"37de914a8a34feafbb5f13e095dbe17e45584c6e6135f63e3c34b2fc61721490",
+     "f886d3076c2390238f62550ea26cc686a6994e8c42d3ce0b6716fb7f75ceffe3"
+     "dbf19a7665cae3f528c0a4a31d9813818fa94e3b0aed9e18eaaf028fcfd87802"},
+};
+
+static void from_hex(const char *hex, uint8_t *bytes, size_t size) {
+    for(size_t i = 0; i < size; i++) {
+        char byte[3] = {hex[2 * i], hex[2 * i + 1], 0};
+        bytes[i] = (uint8_t)strtoul(byte, NULL, 16);
+    }
+}
+
+static void vli_from_hex(const char *hex, uECC_word_t *vli) {
+    uint8_t bytes[32];
+    from_hex(hex, bytes, sizeof(bytes));
+    uECC_vli_bytesToNative(vli, bytes, sizeof(bytes));
+}
+
+// Inputs in [p, 2^256) are outside the field, and only need a result congruent to the answer
+static bool field_equal(const uECC_word_t *result, const uECC_word_t *expected, bool reduced, uECC_Curve curve) {
+    uECC_word_t canonical[NUM_WORDS];
+    uECC_vli_set(canonical, result, NUM_WORDS);
+    if(!reduced && uECC_vli_cmp(uECC_curve_p(curve), canonical, NUM_WORDS) <= 0) {
+        uECC_vli_sub(canonical, canonical, uECC_curve_p(curve), NUM_WORDS);
+    }
+    return uECC_vli_equal(canonical, expected, NUM_WORDS);
+}
+
+int main() {
+    uECC_Curve curve = uECC_secp256k1();
+    wordcount_t num_words = NUM_WORDS;
+    uECC_word_t left[NUM_WORDS], right[NUM_WORDS], expected[NUM_WORDS], result[NUM_WORDS];
+
+    for(size_t v = 0; v < sizeof(MULT_VECTORS) / sizeof(MULT_VECTORS[0]); v++) {
+        vli_from_hex(MULT_VECTORS[v][0], left);
+        vli_from_hex(MULT_VECTORS[v][1], right);
+        vli_from_hex(MULT_VECTORS[v][2], expected);
+        bool reduced = uECC_vli_cmp(uECC_curve_p(curve), left, num_words) > 0
+            && uECC_vli_cmp(uECC_curve_p(curve), right, num_words) > 0;
+
+        uECC_vli_modMult_fast(result, left, right, curve);
+        CHECK(field_equal(result, expected, reduced, curve));
+        uECC_vli_modMult_fast(result, right, left, curve);
+        CHECK(field_equal(result, expected, reduced, curve));
+
+        // In place, as the point formulas call it
+        uECC_vli_set(result, left, num_words);
+        uECC_vli_modMult_fast(result, result, right, curve);
+        CHECK(field_equal(result, expected, reduced, curve));
+
+        if(uECC_vli_equal(left, right, num_words)) {
+            uECC_vli_modSquare_fast(result, left, curve);
+            CHECK(field_equal(result, expected, reduced, curve));
+            uECC_vli_set(result, left, num_words);
+            uECC_vli_modSquare_fast(result, result, curve);
+            CHECK(field_equal(result, expected, reduced, curve));
+        }
+    }
+
+    // A long chain of products and squares against the generic reduction
+    uECC_word_t product[2 * NUM_WORDS];
+    vli_from_hex(MULT_VECTORS[sizeof(MULT_VECTORS) / sizeof(MULT_VECTORS[0]) - 1][0], left);
+    vli_from_hex(MULT_VECTORS[sizeof(MULT_VECTORS) / sizeof(MULT_VECTORS[0]) - 1][1], right);
+    for(int i = 0; i < 1000; i++) {
+        uECC_vli_mult(product, left, right, num_words);
+        uECC_vli_mmod(expected, product, uECC_curve_p(curve), num_words);
+        uECC_vli_modMult_fast(result, left, right, curve);
+        CHECK(uECC_vli_equal(result, expected, num_words));
+
+        uECC_vli_square(product, result, num_words);
+        uECC_vli_mmod(expected, product, uECC_curve_p(curve), num_words);
+        uECC_vli_modSquare_fast(right, result, curve);
+        CHECK(uECC_vli_equal(right, expected, num_words));
+        uECC_vli_set(left, result, num_words);
+    }
+
+    for(size_t v = 0; v < sizeof(KEY_VECTORS) / sizeof(KEY_VECTORS[0]); v++) {
+        uint8_t privkey[32], expected_pubkey[64], pubkey[64];
+        from_hex(KEY_VECTORS[v][0], privkey, sizeof(privkey));
+        from_hex(KEY_VECTORS[v][1], expected_pubkey, sizeof(expected_pubkey));
+        CHECK(uECC_compute_public_key(privkey, pubkey, curve));
+        CHECK(memcmp(pubkey, expected_pubkey, sizeof(pubkey)) == 0);
+    }
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,134 @@
+// Keccak-256 known answers, built as test_keccak (the permutation the build picks by default:
+// bit-interleaved on ARM, unrolled elsewhere), test_keccak-compact and test_keccak-bi32. Messages
+// up to, at and just past the 136-byte block, and over several blocks, go in whole, in odd-sized
+// pieces and from an unaligned buffer, and through the one-block and batch entry points where
+// they apply. For a 32-bit ARM build under qemu-arm, see the Makefile.
+
+#include "test.h"
+#include "keccak256.h"
+
+#include <stdint.h>
+#include <string.h>
+
+// Keccak-256 (not SHA3-256) of the first 'length' bytes of message
+static const struct {
+    uint16_t length;
+    uint8_t hash[32];
+} VECTORS[] = {
+    {0, {
+        0xc5, 0xd2, 0x46, 0x01, 0x86, 0xf7, 0x23, 0x3c, 0x92, 0x7e, 0x7d, 0xb2, 0xdc, 0xc7, 0x03, 0xc0,
+        0xe5, 0x00, 0xb6, 0x53, 0xca, 0x82, 0x27, 0x3b, 0x7b, 0xfa, 0xd8, 0x04, 0x5d, 0x85, 0xa4, 0x70
+    }},
+    {1, {
+        0xee, 0x2a, 0x4b, 0xc7, 0xdb, 0x81, 0xda, 0x2b, 0x71, 0x64, 0xe5, 0x6b, 0x36, 0x49, 0xb1, 0xe2,
+        0xa0, 0x9c, 0x58, 0xc4, 0x55, 0xb1, 0x5d, 0xab, 0xdd, 0xd9, 0x14, 0x6c, 0x75, 0x82, 0xce, 0xbc
+    }},
+    {55, {
+        0x97, 0xc4, 0x5d, 0x97, 0xc8, 0x02, 0xda, 0x7b, 0x3a, 0x65, 0x84, 0xd9, 0x1c, 0x34, 0xee, 0x4e,
+        0xa5, 0xcd, 0x8d, 0x8b, 0x05, 0x28, 0x56, 0x23, 0x44, 0x05, 0xbf, 0x5b, 0x76, 0xc0, 0xb0, 0x43
+    }},
+    {135, {
+        0xad, 0xee, 0x81, 0x45, 0xbb, 0x33, 0xdc, 0x03, 0x20, 0xad, 0x44, 0x94, 0x5e, 0xee, 0xb3, 0x91,
+        0xe4, 0x66, 0x8f, 0x0f, 0x7c, 0x69, 0xcc, 0xbb, 0xf6, 0x55, 0x0a, 0x7c, 0xba, 0x24, 0x5e, 0x52
+    }},
+    {136, {
+        0xea, 0xcc, 0xfc, 0x5a, 0xa7, 0xbf, 0x6b, 0xf1, 0x94, 0x18, 0x09, 0xef, 0x7c, 0xc9, 0xee, 0x6a,
+        0x2f, 0xa3, 0x06, 0xa7, 0xdd, 0x1d, 0xe3, 0xf2, 0xe8, 0x50, 0x48, 0x49, 0xb0, 0xa5, 0xe3, 0xc4
+    }},
+    {137, {
+        0xea, 0x0e, 0x0b, 0x96, 0x57, 0x46, 0x9f, 0x0b, 0x4f, 0x53, 0x60, 0x4f, 0x10, 0x68, 0xab, 0x4b,
+        0xd4, 0xa5, 0xe7, 0xb0, 0xa4, 0x58, 0xd2, 0x4a, 0x78, 0xf1, 0xfe, 0x2e, 0xc7, 0xbd, 0x4d, 0xb0
+    }},
+    {200, {
+        0xaf, 0x34, 0xd3, 0x6e, 0x1e, 0x9e, 0xb1, 0x8d, 0xf4, 0xa7, 0x9a, 0x5a, 0x83, 0x04, 0x30, 0x07,
+        0x00, 0xd1, 0x64, 0x01, 0x4a, 0x5d, 0x64, 0x00, 0x43, 0x81, 0x16, 0xdf, 0xc1, 0xd9, 0xdb, 0x28
+    }},
+    {271, {
+        0x40, 0x78, 0x71, 0xb4, 0x19, 0xdc, 0xa1, 0x5e, 0x03, 0x3d, 0xd9, 0x77, 0x71, 0x54, 0xaf, 0x21,
+        0x16, 0x32, 0x6a, 0x78, 0x49, 0xea, 0xca, 0xdb, 0xc4, 0x6b, 0x16, 0x18, 0x05, 0x5e, 0xe0, 0xa2
+    }},
+    {272, {
+        0xc6, 0x2d, 0x6a, 0x60, 0x78, 0x0d, 0x4e, 0x03, 0x40, 0x88, 0x34, 0x06, 0x2e, 0x58, 0x00, 0x4a,
+        0x54, 0x9c, 0xff, 0x1c, 0x74, 0x87, 0xc0, 0xb9, 0xa1, 0x30, 0x81, 0x06, 0x21, 0xb0, 0xfc, 0xae
+    }},
+    {273, {
+        0xb4, 0x7c, 0xa6, 0x93, 0xc8, 0xd6, 0x75, 0xaf, 0xa3, 0xb0, 0xb6, 0x44, 0xda, 0x6d, 0xc9, 0x66,
+        0x13, 0xf0, 0x7c, 0x6f, 0x89, 0x71, 0xf9, 0xa0, 0x07, 0x7e, 0xd6, 0xb7, 0xc9, 0x94, 0x56, 0x1d
+    }},
+    {1000, {
+        0xc7, 0x7d, 0x9b, 0xff, 0xca, 0xe9, 0xf0, 0x98, 0x4e, 0x6d, 0xff, 0x7e, 0xea, 0x63, 0xcc, 0x14,
+        0xca, 0xd5, 0xf3, 0x67, 0xf7, 0x91, 0xe2, 0x7b, 0x08, 0xa1, 0x95, 0x3f, 0x19, 0x2f, 0x30, 0xa5
+    }},
+};
+
+#define VECTOR_COUNT (sizeof(VECTORS) / sizeof(VECTORS[0]))
+
+static const uint8_t ABC_HASH[32] = {
+        0x4e, 0x03, 0x65, 0x7a, 0xea, 0x45, 0xa9, 0x4f, 0xc7, 0xd4, 0x7b, 0xa8, 0x26, 0xc8, 0xd6, 0x67,
+        0xc0, 0xd1, 0xe6, 0xe3, 0x3a, 0x64, 0xa0, 0x36, 0xec, 0x44, 0xf5, 0x8f, 0xa1, 0x2d, 0x6c, 0x45
+    };
+
+static uint8_t message[1001];   // One spare byte, so it can be hashed from an odd address
+
+static void hash_pieces(const uint8_t *data, uint16_t length, const uint16_t *pieces, uint8_t *result) {
+    SHA3_CTX ctx;
+    keccak_init(&ctx);
+    uint16_t done = 0;
+    for(int i = 0; done < length; i = pieces[i + 1] ? i + 1 : 0) {
+        uint16_t n = length - done < pieces[i] ? length - done : pieces[i];
+        keccak_update(&ctx, data + done, n);
+        done += n;
+    }
+    keccak_final(&ctx, result);
+}
+
+int main() {
+    for(size_t i = 0; i < sizeof(message); i++) {
+        message[i] = (uint8_t)(i * 31 + 7);
+    }
+    static uint8_t unaligned[sizeof(message) + 1];
+
+    static const uint16_t whole[] = {0xffff, 0};
+    static const uint16_t odd[] = {1, 7, 135, 13, 136, 64, 0};
+    uint8_t result[32];
+
+    for(size_t v = 0; v < VECTOR_COUNT; v++) {
+        uint16_t length = VECTORS[v].length;
+        hash_pieces(message, length, whole, result);
+        CHECK(memcmp(result, VECTORS[v].hash, 32) == 0);
+        hash_pieces(message, length, odd, result);
+        CHECK(memcmp(result, VECTORS[v].hash, 32) == 0);
+
+        memcpy(unaligned + 1, message, length);
+        hash_pieces(unaligned + 1, length, whole, result);
+        CHECK(memcmp(result, VECTORS[v].hash, 32) == 0);
+
+        // Including the lengths that have to leave the single-block path
+        memset(result, 0, sizeof(result));
+        keccak256_short(message, length, result);
+        CHECK(memcmp(result, VECTORS[v].hash, 32) == 0);
+    }
+
+    keccak256_short((const uint8_t*)"abc", 3, result);
+    CHECK(memcmp(result, ABC_HASH, 32) == 0);
+
+    // Every vector at once, and then one fewer, so batches come out both full and partial
+    const uint8_t *msgs[VECTOR_COUNT];
+    uint16_t sizes[VECTOR_COUNT];
+    uint8_t hashes[VECTOR_COUNT][32];
+    uint8_t *results[VECTOR_COUNT];
+    for(uint16_t count = VECTOR_COUNT; count >= VECTOR_COUNT - 1; count--) {
+        memset(hashes, 0, sizeof(hashes));
+        for(uint16_t i = 0; i < count; i++) {
+            msgs[i] = message;
+            sizes[i] = VECTORS[i].length;
+            results[i] = hashes[i];
+        }
+        keccak256_multi(msgs, sizes, results, count);
+        for(uint16_t i = 0; i < count; i++) {
+            CHECK(memcmp(hashes[i], VECTORS[i].hash, 32) == 0);
+        }
+    }
+
+    return TEST_RESULT();
+}
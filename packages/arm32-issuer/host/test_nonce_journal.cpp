@@ -0,0 +1,95 @@
+// The nonce journal must never lose or roll back the latest value appended, whenever the power
+// fails, and must never program over a sector it could not erase.
+
+#include "test.h"
+#include "sim.h"
+#include "mbed_error.h"
+#include "nonce_journal.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+extern bool journal_mounted;
+extern int journal_active;
+
+// Forgets what the journal keeps in RAM
+static void reboot() {
+    journal_mounted = false;
+    journal_active = -1;
+}
+
+// Appends with power cuts at random points, checking after each reboot that the journal holds
+// the last value known to be appended, or the one that was being appended
+static void test_power_cuts() {
+    memset(sim_flash, 0xAB, sizeof(sim_flash));
+    srand(1);
+    reboot();
+    uint32_t value;
+    CHECK(nonce_journal_read(&value) == MBED_ERROR_ITEM_NOT_FOUND);
+
+    uint32_t committed = 0;
+    bool have = false;
+    for(int i = 0; i < 20000; i++) {
+        uint32_t next = committed + 256;
+        sim_flash_budget = rand() % 7 == 0 ? rand() % 12 : -1;
+        bool ok = false;
+        try {
+            ok = nonce_journal_append(next) == MBED_SUCCESS;
+            if(rand() % 3 == 0) {
+                nonce_journal_maintain();
+            }
+        } catch(sim_power_cut) {
+        }
+        sim_flash_budget = -1;
+        if(ok) {
+            committed = next;
+            have = true;
+        }
+
+        if(!ok || rand() % 5 == 0) {
+            reboot();
+            int ret = nonce_journal_read(&value);
+            if(ret == MBED_SUCCESS) {
+                // A cut write may still have landed
+                CHECK(value == committed || value == next);
+                committed = value;
+            } else {
+                CHECK(!have);
+            }
+        }
+    }
+    CHECK(have);
+    CHECK(sim_flash_erases > 0);
+}
+
+// When the active sector fills up without a good entry, the latest value is still in the
+// spare, which can't be erased; appending must fail rather than write after it
+static void test_spare_in_use() {
+    const uint32_t magic = 0x4E4A524E;
+    uint8_t *spare = sim_flash;
+    uint8_t *active = sim_flash + SIM_FLASH_SECTOR_SIZE;
+    memset(sim_flash, 0xFF, sizeof(sim_flash));
+    uint32_t spare_slots[] = {magic, 1, 1000, ~1000u};
+    memcpy(spare, spare_slots, sizeof(spare_slots));
+    uint32_t active_header[] = {magic, 2};
+    memset(active, 0, SIM_FLASH_SECTOR_SIZE);
+    memcpy(active, active_header, sizeof(active_header));
+
+    uint8_t before[sizeof(sim_flash)];
+    memcpy(before, sim_flash, sizeof(sim_flash));
+    reboot();
+    uint32_t value;
+    CHECK(nonce_journal_read(&value) == MBED_SUCCESS && value == 1000);
+    CHECK(nonce_journal_maintain() == MBED_SUCCESS);
+    CHECK(nonce_journal_append(2000) != MBED_SUCCESS);
+    CHECK(memcmp(before, sim_flash, sizeof(sim_flash)) == 0);
+
+    reboot();
+    CHECK(nonce_journal_read(&value) == MBED_SUCCESS && value == 1000);
+}
+
+int main() {
+    test_power_cuts();
+    test_spare_in_use();
+    return TEST_RESULT();
+}
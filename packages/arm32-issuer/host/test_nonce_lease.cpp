@@ -0,0 +1,158 @@
+// NonceLease must never hand out a nonce twice, across threads and processes sharing a lease
+// file, and must not start again from 0 when the file can't be read.
+
+#include "test.h"
+#include "nonce_lease.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define PROCESSES 4
+#define THREADS 4
+#define NONCES_PER_THREAD 20000
+
+// Takes nonces on several threads, writing them to 'out_path'; returns an exit status
+static int worker(const char *lease_path, const char *out_path) {
+    NonceLease lease(257);
+    if(lease.open(lease_path) != 0) {
+        return 2;
+    }
+    std::vector<std::vector<uint64_t>> taken(THREADS);
+    std::vector<std::thread> threads;
+    std::atomic<bool> failed(false);
+    for(int t = 0; t < THREADS; t++) {
+        threads.emplace_back([&, t] {
+            for(int i = 0; i < NONCES_PER_THREAD; i++) {
+                uint64_t nonce;
+                if(lease.next(&nonce) != 0) {
+                    failed = true;
+                    return;
+                }
+                taken[t].push_back(nonce);
+            }
+        });
+    }
+    for(auto &thread : threads) {
+        thread.join();
+    }
+    if(failed) {
+        return 3;
+    }
+
+    FILE *out = fopen(out_path, "wb");
+    if(out == NULL) {
+        return 4;
+    }
+    for(auto &nonces : taken) {
+        // Each thread sees its nonces in increasing order
+        for(size_t i = 1; i < nonces.size(); i++) {
+            if(nonces[i] <= nonces[i - 1]) {
+                return 5;
+            }
+        }
+        fwrite(nonces.data(), sizeof(uint64_t), nonces.size(), out);
+    }
+    fclose(out);
+    return 0;
+}
+
+static void test_processes(const std::string &dir) {
+    std::string lease_path = dir + "/lease";
+    for(int p = 0; p < PROCESSES; p++) {
+        if(fork() == 0) {
+            std::string out_path = dir + "/out." + std::to_string(p);
+            _exit(worker(lease_path.c_str(), out_path.c_str()));
+        }
+    }
+    for(int p = 0; p < PROCESSES; p++) {
+        int status;
+        wait(&status);
+        CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+
+    std::vector<uint64_t> all;
+    for(int p = 0; p < PROCESSES; p++) {
+        std::string out_path = dir + "/out." + std::to_string(p);
+        FILE *in = fopen(out_path.c_str(), "rb");
+        CHECK(in != NULL);
+        if(in == NULL) {
+            continue;
+        }
+        uint64_t nonce;
+        while(fread(&nonce, sizeof(nonce), 1, in) == 1) {
+            all.push_back(nonce);
+        }
+        fclose(in);
+        unlink(out_path.c_str());
+    }
+    CHECK(all.size() == PROCESSES * THREADS * NONCES_PER_THREAD);
+    std::sort(all.begin(), all.end());
+    CHECK(std::adjacent_find(all.begin(), all.end()) == all.end());
+
+    // A later process carries on after every lease taken
+    NonceLease lease(10);
+    CHECK(lease.open(lease_path.c_str()) == 0);
+    uint64_t nonce;
+    CHECK(lease.next(&nonce) == 0);
+    CHECK(nonce > all.back());
+    unlink(lease_path.c_str());
+}
+
+// Overwrites the record in 'slot' with garbage, as a write torn by a crash would leave it
+static void tear(const char *path, int slot) {
+    int fd = open(path, O_WRONLY);
+    uint8_t garbage[32];
+    memset(garbage, 0x5A, sizeof(garbage));
+    CHECK(pwrite(fd, garbage, sizeof(garbage), slot * sizeof(garbage)) == sizeof(garbage));
+    close(fd);
+}
+
+static void test_torn_records(const std::string &dir) {
+    std::string path = dir + "/torn";
+    uint64_t nonce;
+    {
+        // Two leases: 0-9 recorded in slot 1, then 10-19 in slot 0
+        NonceLease first(10), second(10);
+        CHECK(first.open(path.c_str()) == 0 && second.open(path.c_str()) == 0);
+        CHECK(first.next(&nonce) == 0 && nonce == 0);
+        CHECK(second.next(&nonce) == 0 && nonce == 10);
+    }
+
+    // Had the second lease's write been torn, it would never have been used; the first
+    // record still says where to carry on from
+    tear(path.c_str(), 0);
+    {
+        NonceLease lease(10);
+        CHECK(lease.open(path.c_str()) == 0);
+        CHECK(lease.next(&nonce) == 0 && nonce == 10);
+    }
+
+    // With both records unreadable, nothing is handed out
+    tear(path.c_str(), 0);
+    tear(path.c_str(), 1);
+    {
+        NonceLease lease(10);
+        CHECK(lease.open(path.c_str()) == 0);
+        CHECK(lease.next(&nonce) == -EIO);
+    }
+    unlink(path.c_str());
+}
+
+int main() {
+    char dir[] = "/tmp/nonce_lease.XXXXXX";
+    CHECK(mkdtemp(dir) != NULL);
+    test_processes(dir);
+    test_torn_records(dir);
+    rmdir(dir);
+    return TEST_RESULT();
+}
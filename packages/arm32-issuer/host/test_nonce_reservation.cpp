@@ -0,0 +1,75 @@
+// Nonce blocks must be reserved from idle work (maintain_store), so that handing out a nonce on
+// a tap never waits for a storage write, and no nonce is handed out before it is reserved. Each
+// tap is timed in simulated flash time (sim.h), which includes the garbage collection stalls a
+// write can hit.
+
+#include "test.h"
+#include "sim.h"
+#include "mbed_error.h"
+#include "storage.h"
+#include "config.h"
+#include "kvstore_global_api.h"
+
+#include <algorithm>
+
+extern uint32_t next_nonce;
+
+static uint32_t stored_nonce() {
+    uint32_t nonce = 0;
+    size_t size;
+    kv_get(NEXT_NONCE_KEY_PATH, &nonce, sizeof(nonce), &size);
+    return nonce;
+}
+
+#define TAPS 100000
+
+// Flash time spent in get_next_nonce on each tap
+static uint64_t tap_ns[TAPS - 1];
+
+int main() {
+    sim_kv_clear();
+    next_nonce = 0xffffffff;
+
+    // Boot: the first prefetch takes a nonce before any idle work has run
+    uint32_t nonce;
+    uint32_t sets = sim_kv_sets;
+    CHECK(get_next_nonce(&nonce) == MBED_SUCCESS);
+    CHECK(nonce == 0);
+    CHECK(sim_kv_sets - sets == 1);
+    CHECK(maintain_store() == MBED_SUCCESS);
+
+    // Then each tap takes a nonce, and idle work follows
+    uint32_t tap_writes = 0, idle_writes = 0;
+    uint64_t idle_ns = 0;
+    for(uint32_t i = 1; i < TAPS; i++) {
+        sets = sim_kv_sets;
+        uint64_t start = sim_flash_ns;
+        CHECK(get_next_nonce(&nonce) == MBED_SUCCESS);
+        tap_ns[i - 1] = sim_flash_ns - start;
+        tap_writes += sim_kv_sets - sets;
+        CHECK(nonce == i);
+        CHECK(nonce < stored_nonce());
+
+        sets = sim_kv_sets;
+        start = sim_flash_ns;
+        CHECK(maintain_store() == MBED_SUCCESS);
+        idle_ns += sim_flash_ns - start;
+        idle_writes += sim_kv_sets - sets;
+        CHECK(stored_nonce() - (nonce + 1) >= NONCE_LOW_WATERMARK);
+    }
+    CHECK(tap_writes == 0);
+    CHECK(idle_writes == TAPS / NONCE_BLOCK_SIZE);
+
+    // The writes, and the time they take, all fall to idle work
+    std::sort(tap_ns, tap_ns + TAPS - 1);
+    CHECK(tap_ns[(TAPS - 1) * 99 / 100] == 0);
+    CHECK(tap_ns[TAPS - 2] == 0);
+    CHECK(idle_ns >= (uint64_t)idle_writes * SIM_KV_RECORD_HEADER * SIM_FLASH_PROGRAM_NS);
+
+    // After a reset, nonces carry on past everything reserved
+    next_nonce = 0xffffffff;
+    uint32_t reserved = stored_nonce();
+    CHECK(get_next_nonce(&nonce) == MBED_SUCCESS);
+    CHECK(nonce == reserved);
+    return TEST_RESULT();
+}
@@ -0,0 +1,73 @@
+// Presignatures must only ever be used for the auth message they were made for: when a nonce
+// comes round with another claimant, its presignature (and so r) must change.
+
+#include "test.h"
+#include "sim.h"
+#include "mbed_error.h"
+#include "presign.h"
+#include "claims.h"
+#include "claim_seed.h"
+#include "storage.h"
+#include "uECC.h"
+
+#include <string.h>
+
+extern uint32_t seed_prf_start;
+
+// Takes the presignature for 'nonce', if one matches the current claim for it
+static bool take(address_t validator, uint32_t nonce, presig_t presig) {
+    hash_t messagehash;
+    if(get_claim_hash(validator, nonce, messagehash) != MBED_SUCCESS) {
+        return false;
+    }
+    return presign_take(nonce, messagehash, presig);
+}
+
+static void refill(privkey_t issuer_key, address_t validator) {
+    int ret;
+    while((ret = presign_refill(issuer_key, validator)) > 0);
+    CHECK(ret == 0);
+}
+
+int main() {
+    privkey_t issuer_key;
+    pubkey_t issuer_pubkey;
+    address_t validator = {0x11};
+    presig_t before, after;
+    hash_t messagehash;
+    sig_t sig;
+
+    sim_kv_clear();
+    CHECK(get_issuer_key(issuer_key) == MBED_SUCCESS);
+    CHECK(uECC_compute_public_key(issuer_key, issuer_pubkey, uECC_secp256k1()));
+    CHECK(claim_seed_init() == MBED_SUCCESS);
+    uint32_t nonce;
+    CHECK(peek_next_nonce(&nonce) == MBED_SUCCESS);
+
+    refill(issuer_key, validator);
+    CHECK(take(validator, nonce, before));
+
+    // Give the nonce another claim seed, and so another claimant, as a store reset used to
+    seed_prf_start = nonce + 1;
+    presign_reset();
+    refill(issuer_key, validator);
+    CHECK(take(validator, nonce, after));
+    CHECK(memcmp(before, after, 32) != 0);
+
+    // A presignature made before the claimant changed must not be handed out for the new one
+    presign_reset();
+    seed_prf_start = 0;
+    refill(issuer_key, validator);
+    seed_prf_start = nonce + 1;
+    CHECK(!take(validator, nonce, after));
+
+    // What is handed out still signs the claim
+    presign_reset();
+    refill(issuer_key, validator);
+    CHECK(get_claim_hash(validator, nonce, messagehash) == MBED_SUCCESS);
+    CHECK(presign_take(nonce, messagehash, after));
+    CHECK(ethers_signWithPresig(issuer_key, messagehash, after, sig));
+    CHECK(uECC_verify(issuer_pubkey, messagehash, sizeof(hash_t), sig, uECC_secp256k1()));
+
+    return TEST_RESULT();
+}
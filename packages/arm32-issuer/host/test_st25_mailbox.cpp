@@ -0,0 +1,74 @@
+// The fast transfer mailbox, as the firmware drives it in mailbox mode
+
+#include "test.h"
+#include "mock_st25.h"
+
+#include <string.h>
+
+static int put(ST25 &st, const char *message) {
+    Span<const uint8_t> part((const uint8_t*)message, strlen(message));
+    return st.write_mailbox_parts(st25_parts_t(&part, 1));
+}
+
+// Messages go in from parts, replace any that is waiting, and are reported pending until read
+static void test_write_and_pending() {
+    MockST25 st(0, 0);
+    MockI2C &mock = st.mock();
+    uint8_t out[ST25_MAILBOX_SIZE];
+
+    CHECK(st.mailbox_pending() == 0);
+    const uint8_t hello[] = "hello ", world[] = "world";
+    Span<const uint8_t> parts[] = {Span<const uint8_t>(hello, 6), Span<const uint8_t>(world, 5)};
+    CHECK(st.write_mailbox_parts(st25_parts_t(parts, 2)) == 0);
+    CHECK(st.mailbox_pending() == 1);
+
+    // The device would refuse to overwrite the unread message; the driver clears it first
+    CHECK(st.write_mailbox_parts(st25_parts_t(parts, 1)) == 0);
+    CHECK(mock.rf_read_message(out) == 6);
+    CHECK(memcmp(out, "hello ", 6) == 0);
+    CHECK(st.mailbox_pending() == 0);
+
+    // The read raises RF_GET_MSG once
+    CHECK(st.read_dynamic_register(ST25_DYN_IT_STS) & ST25_IT_RF_GET_MSG);
+    CHECK(st.read_dynamic_register(ST25_DYN_IT_STS) == 0);
+    CHECK(mock.rf_read_message(out) == -1);
+
+    // A message has to fit the mailbox, and can fill it
+    uint8_t big[ST25_MAILBOX_SIZE + 1];
+    memset(big, 0x5A, sizeof(big));
+    Span<const uint8_t> too_big(big, sizeof(big)), full(big, ST25_MAILBOX_SIZE), empty(big, 0);
+    CHECK(st.write_mailbox_parts(st25_parts_t(&too_big, 1)) != 0);
+    CHECK(st.write_mailbox_parts(st25_parts_t(&empty, 1)) != 0);
+    CHECK(st.write_mailbox_parts(st25_parts_t(&full, 1)) == 0);
+    CHECK(mock.rf_read_message(out) == ST25_MAILBOX_SIZE);
+    CHECK(memcmp(out, big, ST25_MAILBOX_SIZE) == 0);
+
+    // SRAM writes take no EEPROM programming
+    CHECK(st.write_stats().rows_written == 0);
+}
+
+// A reconfiguration drops the code waiting in the mailbox, so readers never fetch one made for
+// the old validator or URL, and the replacement goes in straight away
+static void test_reconfigure() {
+    MockST25 st(0, 0);
+    MockI2C &mock = st.mock();
+    uint8_t out[ST25_MAILBOX_SIZE];
+
+    CHECK(put(st, "old config") == 0);
+    CHECK(st.mailbox_pending() == 1);
+
+    CHECK(st.enable_mailbox() == 0);
+    CHECK(st.mailbox_pending() == 0);
+    CHECK(mock.rf_read_message(out) == -1);
+
+    CHECK(put(st, "new config") == 0);
+    CHECK(st.mailbox_pending() == 1);
+    CHECK(mock.rf_read_message(out) == 10);
+    CHECK(memcmp(out, "new config", 10) == 0);
+}
+
+int main() {
+    test_write_and_pending();
+    test_reconfigure();
+    return TEST_RESULT();
+}
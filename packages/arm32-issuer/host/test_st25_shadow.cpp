@@ -0,0 +1,89 @@
+// The ST25 driver's shadow of user memory must match the EEPROM, or writes that only program
+// changed rows would leave stale bytes behind.
+
+#include "test.h"
+#include "mock_st25.h"
+
+#include <string.h>
+
+static void fill(uint8_t *buf, int len, uint8_t value) {
+    for(int i = 0; i < len; i++) {
+        buf[i] = value + i;
+    }
+}
+
+// On a part smaller than ST25_SHADOW_SIZE, the shadow only covers the memory there is
+static void test_small_part() {
+    MockST25 st(0, 0);
+    MockI2C &mock = st.mock();
+    mock.set_memory_size(512);
+
+    uint8_t data[16];
+    fill(data, sizeof(data), 1);
+    CHECK(st.write(Span<const uint8_t>(data, sizeof(data)), 0x1F0) == 0);
+    CHECK(memcmp(mock.user_mem + 0x1F0, data, sizeof(data)) == 0);
+
+    // Filling the shadow worked, so writing the same bytes again programs nothing
+    st.reset_write_stats();
+    CHECK(st.write(Span<const uint8_t>(data, sizeof(data)), 0x1F0) == 0);
+    CHECK(st.write_stats().rows_written == 0);
+
+    // Reads at the end of memory keep working with the shadow in place
+    uint8_t back[16];
+    CHECK(st.read(back, sizeof(back), 0x1F0) == 0);
+    CHECK(memcmp(back, data, sizeof(data)) == 0);
+}
+
+// A write running past the end of the shadow must still update the rows it covers
+static void test_straddling_write() {
+    MockST25 st(0, 0);
+    MockI2C &mock = st.mock();
+    mock.set_memory_size(2048);
+
+    uint8_t first[8], straddling[16];
+    fill(first, sizeof(first), 10);
+    fill(straddling, sizeof(straddling), 50);
+    uint16_t addr = ST25_SHADOW_SIZE - 8;
+
+    CHECK(st.write(Span<const uint8_t>(first, sizeof(first)), addr) == 0);
+    CHECK(st.write(Span<const uint8_t>(straddling, sizeof(straddling)), addr) == 0);
+    CHECK(memcmp(mock.user_mem + addr, straddling, sizeof(straddling)) == 0);
+
+    // Writing the first bytes back must program them, not match them against a stale shadow
+    CHECK(st.write(Span<const uint8_t>(first, sizeof(first)), addr) == 0);
+    CHECK(memcmp(mock.user_mem + addr, first, sizeof(first)) == 0);
+
+    // Rewriting the straddling bytes only programs the changed shadowed rows, and the
+    // unshadowed ones after them
+    st.reset_write_stats();
+    CHECK(st.write(Span<const uint8_t>(straddling, sizeof(straddling)), addr) == 0);
+    CHECK(st.write_stats().rows_written == 4);
+    st.reset_write_stats();
+    CHECK(st.write(Span<const uint8_t>(straddling, sizeof(straddling)), addr) == 0);
+    CHECK(st.write_stats().rows_written == 2);
+}
+
+// Reads keep the shadow up to date with RF writes
+static void test_rf_write() {
+    MockST25 st(0, 0);
+    MockI2C &mock = st.mock();
+
+    uint8_t data[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    CHECK(st.write(Span<const uint8_t>(data, sizeof(data)), 0x1A0) == 0);
+    mock.user_mem[0x1A2] = 99;
+
+    uint8_t back[8];
+    CHECK(st.read(back, sizeof(back), 0x1A0) == 0);
+    CHECK(back[2] == 99);
+    st.reset_write_stats();
+    CHECK(st.write(Span<const uint8_t>(data, sizeof(data)), 0x1A0) == 0);
+    CHECK(mock.user_mem[0x1A2] == 3);
+    CHECK(st.write_stats().rows_written == 1);
+}
+
+int main() {
+    test_small_part();
+    test_straddling_write();
+    test_rf_write();
+    return TEST_RESULT();
+}
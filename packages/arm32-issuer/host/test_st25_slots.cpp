@@ -0,0 +1,92 @@
+// Publishing through the NDEF slots, including while a reader holds an RF session open and the
+// device NACKs every EEPROM access
+
+#include "test.h"
+#include "mock_st25.h"
+
+#include <string.h>
+
+#define SLOT_SIZE 64
+
+// Finds the NDEF message a reader would see, as it would: the first NDEF TLV after the CC,
+// skipping proprietary ones. Returns its length, or -1 if there is none.
+static int reader_sees(MockI2C &mock, uint8_t *out) {
+    int pos = 4;
+    while(pos + 2 <= mock.user_size) {
+        uint8_t type = mock.user_mem[pos];
+        int len = mock.user_mem[pos + 1], header = 2;
+        if(len == 0xFF) {
+            len = (mock.user_mem[pos + 2] << 8) | mock.user_mem[pos + 3];
+            header = 4;
+        }
+        if(type == 0x03) {
+            memcpy(out, &mock.user_mem[pos + header], len);
+            return len;
+        }
+        if(type != 0xFD) {
+            return -1;
+        }
+        pos += header + len;
+    }
+    return -1;
+}
+
+static int publish(ST25 &st, const char *message) {
+    Span<const uint8_t> part((const uint8_t*)message, strlen(message));
+    return st.publish_ndef_parts(st25_parts_t(&part, 1));
+}
+
+static bool published(MockI2C &mock, const char *message) {
+    uint8_t out[SLOT_SIZE];
+    int len = reader_sees(mock, out);
+    return len == (int)strlen(message) && memcmp(out, message, len) == 0;
+}
+
+static void test_slots(bool slots) {
+    MockST25 st(0, 0);
+    MockI2C &mock = st.mock();
+    CHECK(st.format(60, false, false) == 0);
+    st.set_ndef_slot_size(slots ? SLOT_SIZE : 0);
+    if(slots) {
+        CHECK(st.init_ndef_slots() == 0);
+    }
+
+    // No reader: each message replaces the last
+    CHECK(publish(st, "first") == 0);
+    CHECK(published(mock, "first"));
+    CHECK(publish(st, "second message") == 0);
+    CHECK(published(mock, "second message"));
+    CHECK(mock.rf_nacks == 0);
+
+    // A reader that leaves while the message is staged only delays it
+    mock.rf_session = 12;
+    int sleeps = sim_sleeps;
+    CHECK(publish(st, "third") == 0);
+    CHECK(published(mock, "third"));
+    CHECK(mock.dynamic[ST25_DYN_RF_MNGT - 0x2000] == 0);
+    if(slots) {
+        CHECK(mock.rf_nacks > 0);
+        CHECK(sim_sleeps > sleeps);
+    }
+
+    // One that stays is cut off by putting RF to sleep, once staging has been retried enough
+    mock.rf_session = 1000000;
+    mock.rf_nacks = 0;
+    CHECK(publish(st, "fourth") == 0);
+    CHECK(published(mock, "fourth"));
+    CHECK(mock.rf_session == 0);
+    CHECK(mock.dynamic[ST25_DYN_RF_MNGT - 0x2000] == 0);
+    if(slots) {
+        CHECK(mock.rf_nacks >= ST25_STAGE_ATTEMPTS);
+    }
+
+    // And the next publish starts from where that one left the slots
+    CHECK(publish(st, "fifth") == 0);
+    CHECK(published(mock, "fifth"));
+}
+
+int main() {
+    test_slots(true);
+    test_slots(false);
+    return TEST_RESULT();
+}
@@ -0,0 +1,58 @@
+// The ST25 driver's transfers go through I2C::transfer and complete through its callback; with
+// the mock, a transfer completes before transfer() returns, and the device NACKs while it
+// programs the EEPROM. A transfer whose completion never comes times out, and is aborted.
+
+#include "test.h"
+#include "mock_st25.h"
+
+#include <string.h>
+
+int main() {
+    MockST25 st(0, 0);
+    MockI2C &mock = st.mock();
+    mock.set_memory_size(2048);
+    mock.program_polls = 3;
+
+    // Past the shadow, so every byte is sent; 600 bytes take three transactions of up to 256
+    uint8_t data[600];
+    for(size_t i = 0; i < sizeof(data); i++) {
+        data[i] = i * 7;
+    }
+    int sleeps = sim_sleeps;
+    uint32_t transactions = mock.transactions;
+    CHECK(st.write(Span<const uint8_t>(data, sizeof(data)), 0x400) == 0);
+    CHECK(memcmp(mock.user_mem + 0x400, data, sizeof(data)) == 0);
+
+    // Each transaction is followed by polling until the device answers, sleeping between polls
+    CHECK(sim_sleeps - sleeps == 3 * 3);
+    CHECK(mock.transactions - transactions == 3 * (1 + 3 + 1));
+
+    // Reads come back through the completion callback
+    uint8_t back[sizeof(data)];
+    CHECK(st.read(back, sizeof(back), 0x400) == 0);
+    CHECK(memcmp(back, data, sizeof(data)) == 0);
+
+    // So do errors: past the end of memory, the device NACKs
+    CHECK(st.read(back, 4, 2048) != 0);
+    CHECK(st.write(Span<const uint8_t>(data, 4), 2048) != 0);
+
+    // Registers go to the other device address
+    CHECK(st.write_register(0x18, ST25_REG_ENDA1) == 0);
+    CHECK(mock.registers[ST25_REG_ENDA1] == 0x18);
+    CHECK(st.read_register(ST25_REG_ENDA1) == 0x18);
+    CHECK(st.write_dynamic_register(ST25_RF_SLEEP, ST25_DYN_RF_MNGT) == 0);
+    CHECK(st.read_dynamic_register(ST25_DYN_RF_MNGT) == ST25_RF_SLEEP);
+
+    // A lost completion times out instead of blocking, and the transfer is stopped before the
+    // buffer goes out of scope
+    mock.lose_completions = true;
+    CHECK(st.read(back, 4, 0x400) != 0);
+    CHECK(st.write_register(0x20, ST25_REG_ENDA1) != 0);
+    CHECK(mock.aborts == 2);
+    mock.lose_completions = false;
+    st.wait();
+    CHECK(st.read_register(ST25_REG_ENDA1) >= 0);
+    CHECK(mock.aborts == 2);
+
+    return TEST_RESULT();
+}
@@ -1,3 +1,12 @@
+// Replaces the NDEF message on the tag; a reader in the field only delays it (see st25.cpp)
+int publish_ndef(const st25_parts_t &parts) {
+    int ret = st25.publish_ndef_parts(parts);
+    if(ret != 0) {
+        return MBED_ERROR_FAILED_OPERATION;
+    }
+    return MBED_SUCCESS;
+}
+
 #include "EventQueue.h"
 #include "Kernel.h"
 #include "ThisThread.h"
@@ -20,6 +29,8 @@
 #include "config.h"
 #include "storage.h"
 #include "claims.h"
+#include "presign.h"
+#include "claim_seed.h"
 #include "st25.h"
 #include "shib_ndef.h"
 
@@ -55,18 +66,101 @@
  *
  * Area 2 contains configuration data (see the config_t struct below) and is configured for unauthenticated
  * read access, and write access with RF password 0. This password defaults to 0, but can be updated over RF.
+ *
+ * On parts with 16Kbit or more, the T5T area is grown to hold two NDEF slots (see ST25::init_ndef_slots),
+ * so a new claim code can be written while RF stays enabled, and then shown with a single block write:
+ *
+ * ┌─┬────────────────┬─┐◄─── 0x000
+ * │ │    CC File     │ │
+ * │ ├────────────────┤ │◄─── 0x004
+ * │ │  NDEF slot A   │ │
+ * │ ├────────────────┤ │◄─── 0x134
+ * │ │  NDEF slot B   │ │
+ * │ ├────────────────┤ │◄─── 0x264
+ * │ │   Terminator   │ │
+ * │ └────────────────┘ │◄─── 0x284
+ * │    Area 1 (R/O)    │
+ * ├─┬────────────────┬─┤◄─── 0x320
+ * │ │ Configuration  │ │
+ * │ └────────────────┘ │
+ * │    Area 2 (R/W)    │
+ * └────────────────────┘◄─── end of memory
+ *
+ * Parts of 16Kbit or more that were set up before NDEF slots have their configuration at 0x1A0,
+ * and keep the first layout.
  */
 
 uint8_t ROOT_OF_TRUST[] = {0x5b, 0x22, 0x26, 0xba, 0x20, 0x3d, 0x95, 0x1e, 0xfb, 0x88, 0x20, 0xb8, 0x6f, 0x6b, 0x72, 0x61};
 
-#define EEPROM_END_OF_MEM 0xF
-#define ENDA1 0xB // End of first data area (11 * 32 + 31 = byte 383)
-#define MLEN 32 // 32 * 8 byte words (256 bytes)
-#define CONFIG_ADDRESS 0x1A0
+typedef struct {
+    uint8_t enda1;              // End of first data area, in 32 byte units
+    uint16_t mlen;              // Size of the T5T area, in 8 byte words
+    uint16_t config_address;    // Start of the second data area, holding config_t
+    uint16_t ndef_slot_size;    // Size of each of the two NDEF slots, or 0 for a single NDEF message
+    int min_memory_size;        // Smallest EEPROM (in bytes) this layout fits
+} eeprom_layout_t;
+
+const eeprom_layout_t LAYOUT_SINGLE = {
+    0xB,    // 11 * 32 + 31 = byte 383
+    32,     // 256 bytes
+    0x1A0,
+    0,
+    512
+};
+
+const eeprom_layout_t LAYOUT_SLOTS = {
+    0x18,   // 24 * 32 + 31 = byte 799, leaving 128 bytes after the T5T area
+    80,     // 640 bytes, for two slots and a terminator
+    0x320,
+    304,    // Fits the longest claim code URL with the 4 byte TLV header and a terminator
+    2048
+};
 #define ACTIVE_TIMEOUT chrono::duration<uint32_t,std::milli>(1000) // milliseconds to wait after tag becomes active before starting a new write
 #define CLAIM_PATH "c#"
 #define FLAG_GPO_INTERRUPT 0x1
-#define FLAGS_ALL FLAG_GPO_INTERRUPT
+#define FLAG_CLAIM_READY 0x2 // Set by the prefetch thread once next_claim is ready
+#define FLAGS_ALL (FLAG_GPO_INTERRUPT | FLAG_CLAIM_READY)
+#define PREFETCH_STACK_SIZE 8192 // Claim generation and signing run on the prefetch thread
+
+/*
+ * In mailbox mode, claim codes are handed out through the ST25DV's 256 byte SRAM mailbox rather
+ * than the NDEF message in EEPROM, for readers that fetch it with the fast transfer (Read Message)
+ * command; plain NDEF readers see an empty record. Filling the mailbox takes no EEPROM programming
+ * time or wear, and it empties as the reader fetches it, raising RF_GET_MSG on the GPO pin, so a
+ * new code is written at once and only codes that were actually read are used up.
+ */
+#ifdef MBED_CONF_APP_MAILBOX_MODE
+#define MAILBOX_MODE MBED_CONF_APP_MAILBOX_MODE
+#else
+#define MAILBOX_MODE 0
+#endif
+
+/*
+ * With field detect, the GPO also fires when a reader's field appears or goes. Rising starts work
+ * the next prefetch would otherwise do, and falling after RF activity ends the tap at once, rather
+ * than after ACTIVE_TIMEOUT without interrupts. A field with no RF activity uses up no claim code.
+ */
+#ifdef MBED_CONF_APP_FIELD_DETECT
+#define FIELD_DETECT MBED_CONF_APP_FIELD_DETECT
+#else
+#define FIELD_DETECT 0
+#endif
+
+#if MAILBOX_MODE
+#define GPO_MAILBOX_CONFIG ST25_GPO_RF_GET_MSG_EN
+#define MB_MODE_CONFIG ST25_MB_MODE_ON
+#else
+#define GPO_MAILBOX_CONFIG 0
+#define MB_MODE_CONFIG ST25_MB_MODE_OFF
+#endif
+
+#if FIELD_DETECT
+#define GPO_FIELD_CONFIG ST25_GPO_FIELD_CHANGE_EN
+#else
+#define GPO_FIELD_CONFIG 0
+#endif
+
+#define GPO_CONFIG (ST25_GPO_RF_ACTIVITY_EN | ST25_GPO_RF_WRITE_EN | ST25_GPO_EN | GPO_MAILBOX_CONFIG | GPO_FIELD_CONFIG)
 
 typedef struct {
     char magic_number[8];       // Identifies if this device has been initialised
@@ -87,7 +181,7 @@ const config_t DEFAULT_CONFIG = {
 };
 
 uint8_t EEPROM_REGISTER_INIT[][2] = {
-    {ST25_REG_GPO,          ST25_GPO_RF_ACTIVITY_EN | ST25_GPO_RF_WRITE_EN | ST25_GPO_EN},
+    {ST25_REG_GPO,          GPO_CONFIG},
     {ST25_REG_IT_TIME,      0},
     {ST25_REG_EH_MODE,      ST25_EH_ON_DEMAND},
     {ST25_REG_RF_MNGT,      0},
@@ -95,19 +189,49 @@ uint8_t EEPROM_REGISTER_INIT[][2] = {
     {ST25_REG_RFA2SS,       ST25_R_OPEN_W_AUTH | 1},
     {ST25_REG_I2CSS,        0},
     {ST25_REG_LOCK_CCFILE,  0},
-    {ST25_REG_MB_MODE,      ST25_MB_MODE_OFF},
+    {ST25_REG_MB_MODE,      MB_MODE_CONFIG},
     {ST25_REG_MB_WDG,       0},
     {ST25_REG_LOCK_CFG,     ST25_CONFIG_LOCKED},
     {0,0}
 };
 
+// A claim code's NDEF record, kept in the pieces it is sent to the tag in
+typedef struct {
+    uint8_t header[NDEF_MAX_RECORD_HEADER + 1]; // Record header, including the URI type
+    int header_len;
+    char url[32];               // URL prefix, as configured when prepared
+    int url_len;
+    char code[CLAIMCODE_LEN + 1]; // Base32 claim code, null terminated
+    int status;                 // MBED_SUCCESS, or the error that stopped preparing it
+} prepared_claim_t;
+
+int prepare_claim_code(prepared_claim_t *claim);
+int set_claim_url(prepared_claim_t *claim);
 int write_claim_code(void);
 
 InterruptIn gpo(MBED_CONF_APP_INT, PullUp);
 ST25 st25(MBED_CONF_APP_SDA, MBED_CONF_APP_SCL);
 EventFlags event_flags;
 
+const eeprom_layout_t *layout = &LAYOUT_SINGLE;
+uint8_t eeprom_end_of_mem;     // Last 32 byte unit of the EEPROM
+
+// The claim code for the next tap is generated in the background right after the previous one
+// is written, so a tap only has to wait for the EEPROM write. Each queued prefetch fills
+// next_claim once and sets FLAG_CLAIM_READY; exactly one is outstanding at any time.
+Thread prefetch_thread(osPriorityBelowNormal, PREFETCH_STACK_SIZE, nullptr, "prefetch");
+EventQueue prefetch_queue;
+Mutex prefetch_mutex; // Held while a prefetch runs; keeps config and the key stable under it
+prepared_claim_t next_claim;
+
 privkey_t issuer_key;
+address_t issuer_address;
+bool issuer_loaded = false;     // issuer_key and issuer_address are set; they never change
+bool registers_unlocked = false; // The I2C security session stays open until power is lost
+bool first_claim_written = false;
+uint32_t boot_init_ms;          // Time from power-on to the end of the first initialize_device
+uint32_t first_claim_ms;
+bool boot_time_pending = false; // first_claim_ms is yet to be recorded in storage
 config_t config;
 uint32_t claims_left;
 std::chrono::time_point<Kernel::Clock> claims_last_updated;
@@ -121,49 +245,158 @@ int strnlen(char *s, int maxlen) {
     return maxlen;
 }
 
+bool config_valid(const config_t *c) {
+    return memcmp(c->magic_number, DEFAULT_CONFIG.magic_number, sizeof(DEFAULT_CONFIG.magic_number)) == 0;
+}
+
 int write_config() {
-    return st25.write(Span<uint8_t>((uint8_t*)&config, sizeof(config)), CONFIG_ADDRESS);
+    return st25.write(Span<uint8_t>((uint8_t*)&config, sizeof(config)), layout->config_address);
 }
 
-int write_claim_code(void) {
-    int urllen = strnlen(config.url_string, sizeof(config.url_string));
-    char claimcode[CLAIMCODE_LEN + urllen + sizeof(CLAIM_PATH)];
+/**
+ * Replaces the NDEF message on the tag. RF is put to sleep while a reader could see a partly
+ * written message; with NDEF slots that is only the single block write that flips slots.
+ */
+int publish_ndef(const st25_parts_t &parts) {
+    if(layout->ndef_slot_size != 0) {
+        int ret = st25.stage_ndef_parts(parts);
+        if(ret != 0) {
+            return MBED_ERROR_FAILED_OPERATION;
+        }
+    }
+
+    int ret = st25.write_dynamic_register(ST25_RF_SLEEP, ST25_DYN_RF_MNGT);
+    if(ret != 0) {
+        return MBED_ERROR_FAILED_OPERATION;
+    }
+    if(layout->ndef_slot_size != 0) {
+        ret = st25.flip_ndef();
+    } else {
+        ret = st25.write_ndef_parts(parts);
+    }
+    int wake_ret = st25.write_dynamic_register(0, ST25_DYN_RF_MNGT);
+    if(ret != 0 || wake_ret != 0) {
+        return MBED_ERROR_FAILED_OPERATION;
+    }
+    return MBED_SUCCESS;
+}
+
+int prepare_claim_code(prepared_claim_t *claim) {
     uint32_t nonce;
 
+    // The nonce is used up here; if the code is never written (eg, the device is reconfigured
+    // first), it is skipped, just as a reset skips the rest of a nonce block.
     int ret = get_next_nonce(&nonce);
     if(ret != MBED_SUCCESS) {
         return ret;
     }
 
-    strncat(claimcode, config.url_string, urllen);
-    strcat(claimcode, CLAIM_PATH);
-    ret = generate_claim_code(issuer_key, config.validator, nonce, claimcode + urllen + sizeof(CLAIM_PATH) - 1);
+    memset(claim->code, 0, sizeof(claim->code));
+    ret = generate_claim_code(issuer_key, config.validator, nonce, claim->code);
     if(ret != MBED_SUCCESS) {
         return ret;
     }
 
-    uint8_t buffer[512];
+    return set_claim_url(claim);
+}
+
+// Sets the URL prefix of 'claim' to the configured one; the code itself does not depend on it
+int set_claim_url(prepared_claim_t *claim) {
+    claim->url_len = strnlen(config.url_string, sizeof(config.url_string));
+    memcpy(claim->url, config.url_string, claim->url_len);
+
     uint8_t urltype[] = {0x55};
-    int size = write_ndef_record(
-        buffer,
-        sizeof(buffer),
+    claim->header_len = write_ndef_record_header(
+        claim->header,
+        sizeof(claim->header),
         NDEF_MESSAGE_BEGIN | NDEF_MESSAGE_END | NDEF_TNF_WELL_KNOWN,
         Span<uint8_t>(urltype, 1),
-        Span<uint8_t>((uint8_t*)claimcode, strlen(claimcode)),
+        claim->url_len + sizeof(CLAIM_PATH) - 1 + strlen(claim->code),
         Span<uint8_t>());
+    if(claim->header_len < 0) {
+        return MBED_ERROR_FAILED_OPERATION;
+    }
+
+    return MBED_SUCCESS;
+}
 
-    ret = st25.write_ndef(Span<uint8_t>(buffer, size));
+void prefetch_claim_code() {
+    prefetch_mutex.lock();
+    next_claim.status = prepare_claim_code(&next_claim);
+    event_flags.set(FLAG_CLAIM_READY);
+
+    // Use the rest of the idle time on presignatures, which speed up the next prefetch
+    int ret;
+    while((ret = presign_refill(issuer_key, config.validator)) > 0);
+    if(ret < 0) {
+        // Not fatal; claims are signed without a presignature
+        printf("Presign failed: %d\n", ret);
+    }
+
+    // Reserve more nonces and erase the nonce journal's spare sector as needed, well away
+    // from the next tap
+    ret = maintain_store();
+    if(ret != MBED_SUCCESS) {
+        printf("Storage maintenance failed: %d\n", ret);
+    }
+
+    if(boot_time_pending) {
+        boot_time_pending = false;
+        boot_stats_t stats;
+        ret = record_boot_time(boot_init_ms, first_claim_ms, &stats);
+        if(ret != MBED_SUCCESS) {
+            printf("Recording boot time failed: %d\n", ret);
+        } else {
+            printf("Boot: first claim after %lu ms (initialisation %lu ms); over %lu boots, best %lu ms, worst %lu ms\n",
+                (unsigned long)stats.last_ms, (unsigned long)stats.last_init_ms, (unsigned long)stats.boots,
+                (unsigned long)stats.best_ms, (unsigned long)stats.worst_ms);
+        }
+    }
+    prefetch_mutex.unlock();
+}
+
+// Writes next_claim to the tag; FLAG_CLAIM_READY must have been waited for.
+int write_claim_code(void) {
+    if(next_claim.status != MBED_SUCCESS) {
+        return next_claim.status;
+    }
+
+    // Sent to the tag straight from next_claim and the constant path, without joining them first
+    Span<const uint8_t> parts[] = {
+        Span<const uint8_t>(next_claim.header, next_claim.header_len),
+        Span<const uint8_t>((uint8_t*)next_claim.url, next_claim.url_len),
+        Span<const uint8_t>((const uint8_t*)CLAIM_PATH, sizeof(CLAIM_PATH) - 1),
+        Span<const uint8_t>((uint8_t*)next_claim.code, strlen(next_claim.code)),
+    };
+#if MAILBOX_MODE
+    // The record goes in the mailbox as it is, without a TLV
+    int ret = st25.write_mailbox_parts(st25_parts_t(parts, 4));
     if(ret != 0) {
         return MBED_ERROR_FAILED_OPERATION;
     }
+#else
+    int ret = publish_ndef(st25_parts_t(parts, 4));
+    if(ret != MBED_SUCCESS) {
+        return ret;
+    }
+#endif
+    if(!first_claim_written) {
+        // The kernel clock starts at boot. Recorded by the prefetch, away from the tap.
+        first_claim_ms = chrono::duration_cast<chrono::milliseconds>(Kernel::Clock::now().time_since_epoch()).count();
+        boot_time_pending = true;
+        first_claim_written = true;
+    }
 
     claims_left -= 1;
 
+    // Start on the code for the next tap
+    prefetch_queue.call(prefetch_claim_code);
+
     return MBED_SUCCESS;
 }
 
 int write_empty_ndef(void) {
-    uint8_t buffer[512];
+    uint8_t buffer[NDEF_MAX_RECORD_HEADER];
     int size = write_ndef_record(
         buffer,
         sizeof(buffer),
@@ -172,18 +405,49 @@ int write_empty_ndef(void) {
         Span<uint8_t>(),
         Span<uint8_t>());
     
-    return st25.write_ndef(Span<uint8_t>(buffer, size));
+    Span<const uint8_t> part(buffer, size);
+    return publish_ndef(st25_parts_t(&part, 1));
 }
 
 void initialize_device() {
+    int ret;
+
     // Authenticate with the eeprom for settings access
-    int ret = st25.unlock(0);
-    if(ret != 0) {
-        MBED_ERROR(MBED_ERROR_FAILED_OPERATION, "Unlocking registers");
+    if(!registers_unlocked) {
+        ret = st25.unlock(0);
+        if(ret != 0) {
+            MBED_ERROR(MBED_ERROR_FAILED_OPERATION, "Unlocking registers");
+        }
+        registers_unlocked = true;
     }
 
-    st25.read((uint8_t*)&config, sizeof(config), CONFIG_ADDRESS);
-    if(memcmp(config.magic_number, DEFAULT_CONFIG.magic_number, sizeof(DEFAULT_CONFIG.magic_number)) != 0) {
+    // RF writes may have changed the EEPROM behind our back
+    st25.invalidate_shadow();
+
+    // Pick the EEPROM layout for this part
+    ret = st25.memory_size();
+    if(ret < 0) {
+        MBED_ERROR(MBED_ERROR_FAILED_OPERATION, "Reading memory size");
+    }
+    eeprom_end_of_mem = ret / 32 - 1;
+    layout = ret >= LAYOUT_SLOTS.min_memory_size ? &LAYOUT_SLOTS : &LAYOUT_SINGLE;
+
+    // Kept to tell whether the config needs writing back
+    config_t eeprom_config;
+    st25.read((uint8_t*)&config, sizeof(config), layout->config_address);
+    if(!config_valid(&config) && layout != &LAYOUT_SINGLE) {
+        // Set up before NDEF slots; keep that layout rather than resetting the device and
+        // losing its config
+        config_t single_config;
+        st25.read((uint8_t*)&single_config, sizeof(single_config), LAYOUT_SINGLE.config_address);
+        if(config_valid(&single_config)) {
+            layout = &LAYOUT_SINGLE;
+            memcpy(&config, &single_config, sizeof(config));
+        }
+    }
+    st25.set_ndef_slot_size(layout->ndef_slot_size);
+    memcpy(&eeprom_config, &config, sizeof(config));
+    if(!config_valid(&config)) {
         // Delete issuer key and nonce if they exist
         ret = reset_store();
         if(ret != MBED_SUCCESS) {
@@ -194,10 +458,16 @@ void initialize_device() {
         memcpy((uint8_t*)&config, &DEFAULT_CONFIG, sizeof(DEFAULT_CONFIG));
 
         // Format the NDEF part of the memory
-        ret = st25.format(MLEN, true /* readonly */, true /* mbread */);
+        ret = st25.format(layout->mlen, true /* readonly */, true /* mbread */);
         if(ret != 0) {
             MBED_ERROR(MBED_ERROR_FAILED_OPERATION, "Formatting EEPROM");
         }
+        if(layout->ndef_slot_size != 0) {
+            ret = st25.init_ndef_slots();
+            if(ret != 0) {
+                MBED_ERROR(MBED_ERROR_FAILED_OPERATION, "Formatting NDEF slots");
+            }
+        }
 
         // Write default register settings
         for(int i = 0; EEPROM_REGISTER_INIT[i][0] != 0 || EEPROM_REGISTER_INIT[i][1] != 0; i++) {
@@ -211,8 +481,8 @@ void initialize_device() {
         ret = st25.read_register(ST25_REG_ENDA3);
         if(ret < 0) {
             MBED_ERROR(MBED_ERROR_FAILED_OPERATION, "Reading ENDA3");
-        } else if(ret != EEPROM_END_OF_MEM) {
-            ret = st25.write_register(EEPROM_END_OF_MEM, ST25_REG_ENDA3);
+        } else if(ret != eeprom_end_of_mem) {
+            ret = st25.write_register(eeprom_end_of_mem, ST25_REG_ENDA3);
             if(ret != MBED_SUCCESS) {
                 MBED_ERROR(MBED_ERROR_FAILED_OPERATION, "Writing ENDA3");
             }
@@ -221,8 +491,8 @@ void initialize_device() {
         ret = st25.read_register(ST25_REG_ENDA2);
         if(ret < 0) {
             MBED_ERROR(MBED_ERROR_FAILED_OPERATION, "Reading ENDA2");
-        } else if(ret != EEPROM_END_OF_MEM) {
-            ret = st25.write_register(EEPROM_END_OF_MEM, ST25_REG_ENDA2);
+        } else if(ret != eeprom_end_of_mem) {
+            ret = st25.write_register(eeprom_end_of_mem, ST25_REG_ENDA2);
             if(ret != MBED_SUCCESS) {
                 MBED_ERROR(MBED_ERROR_FAILED_OPERATION, "Writing ENDA2");
             }
@@ -231,33 +501,150 @@ void initialize_device() {
         ret = st25.read_register(ST25_REG_ENDA1);
         if(ret < 0) {
             MBED_ERROR(MBED_ERROR_FAILED_OPERATION, "Reading ENDA1");
-        } else if(ret != ENDA1) {
-            ret = st25.write_register(ENDA1, ST25_REG_ENDA1);
+        } else if(ret != layout->enda1) {
+            ret = st25.write_register(layout->enda1, ST25_REG_ENDA1);
             if(ret != MBED_SUCCESS) {
                 MBED_ERROR(MBED_ERROR_FAILED_OPERATION, "Writing ENDA1");
             }
         }
     }
 
-    // Set up devicekey
-    DeviceKey::get_instance().device_inject_root_of_trust((uint32_t*)ROOT_OF_TRUST, sizeof(ROOT_OF_TRUST));
+    // Devices set up before the mode changed need the registers it depends on updated
+    if(st25.read_register(ST25_REG_GPO) != GPO_CONFIG) {
+        ret = st25.write_register(GPO_CONFIG, ST25_REG_GPO);
+        if(ret != 0) {
+            MBED_ERROR(MBED_ERROR_FAILED_OPERATION, "Writing GPO");
+        }
+    }
+    if(st25.read_register(ST25_REG_MB_MODE) != MB_MODE_CONFIG) {
+        ret = st25.write_register(MB_MODE_CONFIG, ST25_REG_MB_MODE);
+        if(ret != 0) {
+            MBED_ERROR(MBED_ERROR_FAILED_OPERATION, "Writing MB_MODE");
+        }
+    }
+#if MAILBOX_MODE
+    // Also drops any code made for the old configuration
+    ret = st25.enable_mailbox();
+    if(ret != 0) {
+        MBED_ERROR(MBED_ERROR_FAILED_OPERATION, "Enabling mailbox");
+    }
+#endif
 
-    // Write the issuer address to the config
-    ret = get_issuer_address(config.issuer);
+    if(!issuer_loaded) {
+        // Set up devicekey
+        DeviceKey::get_instance().device_inject_root_of_trust((uint32_t*)ROOT_OF_TRUST, sizeof(ROOT_OF_TRUST));
+
+        // The address is normally read from a cache rather than computed from the key
+        ret = load_issuer(issuer_key, issuer_address);
+        if(ret != MBED_SUCCESS) {
+            MBED_ERROR(ret, "Loading issuer key");
+        }
+        issuer_loaded = true;
+    }
+
+    // Claim seeds come from a master secret, taken from the device key the first time
+    ret = claim_seed_init();
     if(ret != MBED_SUCCESS) {
-        MBED_ERROR(ret, "Writing issuer address");
+        MBED_ERROR(ret, "Deriving claim seed secret");
     }
 
-    // Write the config to storage
-    ret = write_config();
-    if(ret != 0) {
-        MBED_ERROR(MBED_ERROR_FAILED_OPERATION, "Writing default config");
+    // Write the issuer address to the config
+    memcpy(config.issuer, issuer_address, sizeof(address_t));
+
+    // Write the config to storage, unless the EEPROM already holds it
+    if(memcmp(&config, &eeprom_config, sizeof(config)) != 0) {
+        ret = write_config();
+        if(ret != 0) {
+            MBED_ERROR(MBED_ERROR_FAILED_OPERATION, "Writing default config");
+        }
     }
 
+    // The validator may have changed
+    presign_reset();
+
     claims_left = 0;
     claims_last_updated = Kernel::Clock::now();
 }
 
+#if FIELD_DETECT
+// Run on the main thread when a field appears. It only uses the MCU and its flash, leaving the
+// ST25 free for the reader. The replacement claim code needs no starting here, since it is
+// prefetched as soon as the last one is written.
+void start_speculative_work() {
+    // A running prefetch holds the mutex, and will do this work itself
+    if(!prefetch_mutex.trylock()) {
+        return;
+    }
+    // Tops up the nonce reservation now, if it is running low
+    int ret = reserve_nonces();
+    if(ret != MBED_SUCCESS) {
+        printf("Nonce reservation failed: %d\n", ret);
+    }
+    prefetch_mutex.unlock();
+}
+#endif
+
+// Returned by reconfigure_device
+#define CONFIG_VALIDATOR_CHANGED 0x1 // The prepared claim code was made for another validator
+#define CONFIG_URL_CHANGED 0x2
+
+/**
+ * Applies a configuration written over RF, touching only the state that depends on the fields
+ * that changed. Called with prefetch_mutex held. Returns the CONFIG_*_CHANGED flags for the
+ * fields that changed.
+ *
+ * RF can only write Area 2, so the NDEF slots and the ST25 shadow of Area 1 stay as they were.
+ * In mailbox mode, a code waiting in the mailbox shows the old validator or URL, so it is
+ * dropped. Without a valid config, it falls back to initialize_device.
+ */
+int reconfigure_device() {
+    config_t eeprom_config;
+    int ret = st25.read((uint8_t*)&eeprom_config, sizeof(eeprom_config), layout->config_address);
+    if(ret != 0 || !config_valid(&eeprom_config)) {
+        // This also empties the mailbox
+        initialize_device();
+        return CONFIG_VALIDATOR_CHANGED | CONFIG_URL_CHANGED;
+    }
+
+    bool validator_changed = memcmp(eeprom_config.validator, config.validator, sizeof(address_t)) != 0;
+    bool url_changed = memcmp(eeprom_config.url_string, config.url_string, sizeof(config.url_string)) != 0;
+    memcpy(config.validator, eeprom_config.validator, sizeof(address_t));
+    memcpy(config.url_string, eeprom_config.url_string, sizeof(config.url_string));
+    config.claim_interval = eeprom_config.claim_interval;
+    config.claim_count = eeprom_config.claim_count;
+
+    // The issuer address is ours; put it back if it was overwritten
+    if(memcmp(&config, &eeprom_config, sizeof(config)) != 0) {
+        ret = write_config();
+        if(ret != 0) {
+            MBED_ERROR(MBED_ERROR_FAILED_OPERATION, "Writing config");
+        }
+    }
+
+    // Claims already in the bucket stay, up to the new limit
+    claims_left = min(config.claim_count, claims_left);
+
+#if MAILBOX_MODE
+    if(validator_changed || url_changed) {
+        ret = st25.enable_mailbox();
+        if(ret != 0) {
+            MBED_ERROR(MBED_ERROR_FAILED_OPERATION, "Clearing mailbox");
+        }
+    }
+#endif
+
+    if(validator_changed) {
+        // Presignatures and the prepared code are bound to the validator; reserved nonces are not
+        presign_reset();
+        return CONFIG_VALIDATOR_CHANGED | (url_changed ? CONFIG_URL_CHANGED : 0);
+    }
+    if(url_changed && (event_flags.get() & FLAG_CLAIM_READY) && next_claim.status == MBED_SUCCESS) {
+        // The prepared code stays valid under the new URL prefix
+        next_claim.status = set_claim_url(&next_claim);
+    }
+    return url_changed ? CONFIG_URL_CHANGED : 0;
+}
+
 void handle_gpo(void) {
     event_flags.set(FLAG_GPO_INTERRUPT);
 }
@@ -282,13 +669,28 @@ struct next_state_t {
 };
 
 struct next_state_t state_idle();
+struct next_state_t end_of_tap();
 
 struct next_state_t state_reinitialize() {
     printf("State: REINITIALIZE\n");
     while(true) {
         int flags = event_flags.wait_any_for(FLAG_GPO_INTERRUPT, ACTIVE_TIMEOUT);
         if(!(flags & FLAG_GPO_INTERRUPT)) {
-            initialize_device();
+            // Wait for any running prefetch, since it reads the configuration
+            prefetch_mutex.lock();
+            int changed = reconfigure_device();
+            if((changed & CONFIG_VALIDATOR_CHANGED) && (event_flags.clear(FLAG_CLAIM_READY) & FLAG_CLAIM_READY)) {
+                // The waiting claim code was made for the old configuration; make a new one.
+                // Otherwise the outstanding prefetch has not started yet, and will use the new one.
+                prefetch_queue.call(prefetch_claim_code);
+            }
+            prefetch_mutex.unlock();
+#if MAILBOX_MODE
+            if(changed != 0) {
+                // The mailbox was emptied; fill it with a code for the new configuration
+                return end_of_tap();
+            }
+#endif
             return {&state_idle};
         }
     }
@@ -296,18 +698,12 @@ struct next_state_t state_reinitialize() {
 
 struct next_state_t state_write_tag() {
     printf("State: WRITE_TAG\n");
-    int ret = st25.write_dynamic_register(ST25_RF_SLEEP, ST25_DYN_RF_MNGT);
-    if(ret != MBED_SUCCESS) {
-        MBED_ERROR(MBED_ERROR_FAILED_OPERATION, "RF sleep");
-    }
-    ret = write_claim_code();
+    // Normally the prefetch finished long ago; if not, let it finish before RF goes to sleep
+    event_flags.wait_any(FLAG_CLAIM_READY);
+    int ret = write_claim_code();
     if(ret != MBED_SUCCESS) {
         MBED_ERROR(ret, "Writing claim code");
     }
-    ret = st25.write_dynamic_register(0, ST25_DYN_RF_MNGT);
-    if(ret != MBED_SUCCESS) {
-        MBED_ERROR(MBED_ERROR_FAILED_OPERATION, "RF wake");
-    }
     return {&state_idle};
 }
 
@@ -315,10 +711,12 @@ struct next_state_t state_delay() {
     // On entering this state, claims_left is 0, and claims_last_updated is in the future
     // On exiting, claims_left is 1 and claims_last_updated is now
     printf("State: DELAY\n");
-    // Replace the tag with empty data
-    st25.write_dynamic_register(ST25_RF_SLEEP, ST25_DYN_RF_MNGT);
-    write_empty_ndef();
-    st25.write_dynamic_register(0, ST25_DYN_RF_MNGT);
+    // Replace the tag with empty data. If that fails, the last code stays up until the next
+    // one is written, which is no reason to stop the issuer.
+    int ret = write_empty_ndef();
+    if(ret != MBED_SUCCESS) {
+        printf("Clearing tag failed: %d\n", ret);
+    }
 
     // Wait until the end of the delay
     std::chrono::time_point<Kernel::Clock> wait_until = claims_last_updated + config.claim_interval * 1s;
@@ -333,21 +731,61 @@ struct next_state_t state_delay() {
     return {&state_write_tag};
 }
 
+// Called once a tap is over, to put the next claim code in its place
+struct next_state_t end_of_tap() {
+#if MAILBOX_MODE
+    // A code nobody fetched stays for the next reader
+    if(st25.mailbox_pending() != 0) {
+        return {&state_idle};
+    }
+#endif
+    if(claims_left > 0) {
+        return {&state_write_tag};
+    } else {
+        return {&state_delay};
+    }
+}
+
 struct next_state_t state_active() {
     printf("State: ACTIVE\n");
+#if FIELD_DETECT
+    bool rf_activity = false;
+#endif
     while(true) {
         int reg = st25.read_dynamic_register(ST25_DYN_IT_STS);
         if(reg & ST25_IT_RF_WRITE) {
             return {&state_reinitialize};
         }
-        
+
+#if MAILBOX_MODE
+        // Refill the mailbox as soon as a reader has fetched it; it needs no quiet RF field
+        if(reg & ST25_IT_RF_GET_MSG) {
+            return claims_left > 0 ? next_state_t{&state_write_tag} : next_state_t{&state_delay};
+        }
+#endif
+
+#if FIELD_DETECT
+        if(reg > 0) {
+            if(reg & ST25_IT_FIELD_RISING) {
+                start_speculative_work();
+            }
+            if(reg & (ST25_IT_RF_ACTIVITY | ST25_IT_RF_USER | ST25_IT_RF_GET_MSG)) {
+                rf_activity = true;
+            }
+            if(reg & ST25_IT_FIELD_FALLING) {
+                return rf_activity ? end_of_tap() : next_state_t{&state_idle};
+            }
+        }
+#endif
+
         int flags = event_flags.wait_any_for(FLAG_GPO_INTERRUPT, ACTIVE_TIMEOUT);
         if(flags == osFlagsErrorTimeout) {
-            if(claims_left > 0) {
-                return {&state_write_tag};
-            } else {
-                return {&state_delay};
+#if FIELD_DETECT
+            if(!rf_activity) {
+                return {&state_idle};
             }
+#endif
+            return end_of_tap();
         }
 
         // Otherwise, it was the GPO interrupt; loop around again
@@ -365,8 +803,12 @@ int main() {
     // rng_init();
     kv_init_storage_config();
     initialize_device();
+    boot_init_ms = chrono::duration_cast<chrono::milliseconds>(Kernel::Clock::now().time_since_epoch()).count();
     gpo.rise(handle_gpo);
 
+    prefetch_thread.start(callback(&prefetch_queue, &EventQueue::dispatch_forever));
+    prefetch_queue.call(prefetch_claim_code);
+
     struct next_state_t state = {&state_delay};
     while(true) {
         state = state.func();
@@ -0,0 +1,257 @@
+#include "nonce_journal.h"
+#include "mbed.h"
+#include "mbed_error.h"
+
+#include <string.h>
+
+#if NONCE_JOURNAL
+
+#define JOURNAL_MAGIC 0x4E4A524E
+#define JOURNAL_MAX_STRIDE 32
+
+typedef struct {
+    uint32_t magic;
+    uint32_t sequence;          // Higher in the newer sector
+} journal_header_t;
+
+typedef struct {
+    uint32_t value;
+    uint32_t check;             // ~value; a torn or unwritten entry fails the check
+} journal_entry_t;
+
+typedef struct {
+    uint32_t address;
+    uint32_t size;
+    bool valid;                 // Has a header
+    uint32_t sequence;
+    int last;                   // Offset of the last valid entry, or -1
+    uint32_t end;               // Offset after the last programmed slot
+} journal_sector_t;
+
+FlashIAP journal_flash;
+journal_sector_t journal_sectors[2];
+int journal_active = -1;        // Sector appends go to, or -1 before the first one
+bool journal_spare_dirty;       // The other sector needs erasing before it can be used
+uint32_t journal_stride;        // Bytes per header or entry, a multiple of the program size
+uint8_t journal_erased;
+bool journal_mounted = false;
+
+static bool slot_erased(uint32_t address) {
+    uint8_t buf[JOURNAL_MAX_STRIDE];
+    if(journal_flash.read(buf, address, journal_stride) != 0) {
+        return false;
+    }
+    for(uint32_t i = 0; i < journal_stride; i++) {
+        if(buf[i] != journal_erased) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int scan_sector(journal_sector_t *sector) {
+    journal_header_t header;
+    int ret = journal_flash.read(&header, sector->address, sizeof(header));
+    if(ret != 0) {
+        return MBED_ERROR_READ_FAILED;
+    }
+    sector->valid = header.magic == JOURNAL_MAGIC;
+    sector->sequence = header.sequence;
+    sector->last = -1;
+    sector->end = 0;
+
+    for(uint32_t offset = 0; offset + journal_stride <= sector->size; offset += journal_stride) {
+        if(!slot_erased(sector->address + offset)) {
+            sector->end = offset + journal_stride;
+        }
+        if(!sector->valid || offset == 0) {
+            continue;
+        }
+        journal_entry_t entry;
+        ret = journal_flash.read(&entry, sector->address + offset, sizeof(entry));
+        if(ret != 0) {
+            return MBED_ERROR_READ_FAILED;
+        }
+        if(entry.check == ~entry.value) {
+            sector->last = offset;
+        }
+    }
+    return MBED_SUCCESS;
+}
+
+// True if sector 'a' was started after sector 'b'
+static bool newer(const journal_sector_t *a, const journal_sector_t *b) {
+    return a->valid && (!b->valid || (int32_t)(a->sequence - b->sequence) > 0);
+}
+
+int nonce_journal_init() {
+    if(journal_mounted) {
+        return MBED_SUCCESS;
+    }
+    if(journal_flash.init() != 0) {
+        return MBED_ERROR_INITIALIZATION_FAILED;
+    }
+
+    journal_stride = journal_flash.get_page_size();
+    while(journal_stride < sizeof(journal_entry_t)) {
+        journal_stride += journal_flash.get_page_size();
+    }
+    if(journal_stride > JOURNAL_MAX_STRIDE) {
+        return MBED_ERROR_UNSUPPORTED;
+    }
+    journal_erased = journal_flash.get_erase_value();
+
+    journal_sectors[0].address = NONCE_JOURNAL_ADDRESS;
+    journal_sectors[0].size = journal_flash.get_sector_size(journal_sectors[0].address);
+    journal_sectors[1].address = journal_sectors[0].address + journal_sectors[0].size;
+    journal_sectors[1].size = journal_flash.get_sector_size(journal_sectors[1].address);
+    for(int i = 0; i < 2; i++) {
+        int ret = scan_sector(&journal_sectors[i]);
+        if(ret != MBED_SUCCESS) {
+            return ret;
+        }
+    }
+
+    if(journal_sectors[0].valid || journal_sectors[1].valid) {
+        journal_active = newer(&journal_sectors[1], &journal_sectors[0]) ? 1 : 0;
+        journal_spare_dirty = journal_sectors[journal_active ^ 1].end != 0;
+    } else {
+        // Never used, or erased along with the rest of the flash
+        journal_active = -1;
+        journal_spare_dirty = journal_sectors[0].end != 0;
+    }
+    journal_mounted = true;
+    return MBED_SUCCESS;
+}
+
+int nonce_journal_read(uint32_t *value) {
+    int ret = nonce_journal_init();
+    if(ret != MBED_SUCCESS) {
+        return ret;
+    }
+    if(journal_active < 0) {
+        return MBED_ERROR_ITEM_NOT_FOUND;
+    }
+
+    // If a reset came between starting a sector and its first entry, the latest is in the other
+    journal_sector_t *sector = &journal_sectors[journal_active];
+    if(sector->last < 0) {
+        sector = &journal_sectors[journal_active ^ 1];
+        if(!sector->valid || sector->last < 0) {
+            return MBED_ERROR_ITEM_NOT_FOUND;
+        }
+    }
+
+    journal_entry_t entry;
+    ret = journal_flash.read(&entry, sector->address + sector->last, sizeof(entry));
+    if(ret != 0) {
+        return MBED_ERROR_READ_FAILED;
+    }
+    *value = entry.value;
+    return MBED_SUCCESS;
+}
+
+static int program_slot(journal_sector_t *sector, const void *data, size_t len) {
+    uint8_t buf[JOURNAL_MAX_STRIDE];
+    memset(buf, journal_erased, sizeof(buf));
+    memcpy(buf, data, len);
+    uint32_t address = sector->address + sector->end;
+    sector->end += journal_stride;
+    if(journal_flash.program(buf, address, journal_stride) != 0) {
+        return MBED_ERROR_WRITE_FAILED;
+    }
+    uint8_t check[JOURNAL_MAX_STRIDE];
+    if(journal_flash.read(check, address, journal_stride) != 0 || memcmp(buf, check, journal_stride) != 0) {
+        return MBED_ERROR_WRITE_FAILED;
+    }
+    return MBED_SUCCESS;
+}
+
+// Starts the spare sector with a header numbered after the active one
+static int start_sector() {
+    int next = journal_active < 0 ? 0 : journal_active ^ 1;
+    if(journal_spare_dirty) {
+        // Only when nonce_journal_maintain has not had a chance to run
+        int ret = nonce_journal_maintain();
+        if(ret != MBED_SUCCESS) {
+            return ret;
+        }
+    }
+
+    journal_sector_t *sector = &journal_sectors[next];
+    if(journal_spare_dirty || sector->end != 0) {
+        // Not erased, as the spare still holds the latest entry; a header can't go after it
+        return MBED_ERROR_WRITE_FAILED;
+    }
+    journal_header_t header = {
+        JOURNAL_MAGIC,
+        journal_active < 0 ? 1 : journal_sectors[journal_active].sequence + 1
+    };
+    int ret = program_slot(sector, &header, sizeof(header));
+    if(ret != MBED_SUCCESS) {
+        return ret;
+    }
+    sector->valid = true;
+    sector->sequence = header.sequence;
+    sector->last = -1;
+    journal_active = next;
+    return MBED_SUCCESS;
+}
+
+int nonce_journal_append(uint32_t value) {
+    int ret = nonce_journal_init();
+    if(ret != MBED_SUCCESS) {
+        return ret;
+    }
+
+    bool switched = false;
+    if(journal_active < 0 || journal_sectors[journal_active].end + journal_stride > journal_sectors[journal_active].size) {
+        ret = start_sector();
+        if(ret != MBED_SUCCESS) {
+            return ret;
+        }
+        switched = true;
+    }
+
+    journal_sector_t *sector = &journal_sectors[journal_active];
+    journal_entry_t entry = {value, ~value};
+    uint32_t offset = sector->end;
+    ret = program_slot(sector, &entry, sizeof(entry));
+    if(ret != MBED_SUCCESS) {
+        // The slot is skipped; the next append goes after it
+        return ret;
+    }
+    sector->last = offset;
+
+    // The old sector is no longer needed, now the new one has an entry
+    if(switched && journal_sectors[journal_active ^ 1].end != 0) {
+        journal_spare_dirty = true;
+    }
+    return MBED_SUCCESS;
+}
+
+int nonce_journal_maintain() {
+    int ret = nonce_journal_init();
+    if(ret != MBED_SUCCESS) {
+        return ret;
+    }
+    if(!journal_spare_dirty) {
+        return MBED_SUCCESS;
+    }
+
+    journal_sector_t *sector = &journal_sectors[journal_active < 0 ? 0 : journal_active ^ 1];
+    if(journal_active >= 0 && journal_sectors[journal_active].last < 0) {
+        // The spare still holds the latest entry
+        return MBED_SUCCESS;
+    }
+    if(journal_flash.erase(sector->address, sector->size) != 0) {
+        return MBED_ERROR_WRITE_FAILED;
+    }
+    sector->valid = false;
+    sector->last = -1;
+    sector->end = 0;
+    journal_spare_dirty = false;
+    return MBED_SUCCESS;
+}
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef NONCE_JOURNAL_H
+#define NONCE_JOURNAL_H
+
+#include <stdint.h>
+
+// Start of the two flash sectors holding the journal. They must be kept out of the application
+// (eg, with target.restrict_size) and out of the TDBStore area. Without it, the nonce is kept in
+// KVStore as before.
+#ifdef MBED_CONF_APP_NONCE_JOURNAL_ADDRESS
+#define NONCE_JOURNAL 1
+#define NONCE_JOURNAL_ADDRESS MBED_CONF_APP_NONCE_JOURNAL_ADDRESS
+#else
+#define NONCE_JOURNAL 0
+#endif
+
+/**
+ * An append-only log of nonce reservations in two flash sectors of their own. Each reservation
+ * programs one entry after the last, so a write costs the same every time, unlike a KVStore set,
+ * which can run into TDBStore garbage collection.
+ *
+ * Each sector starts with a header holding a sequence number, and the newest sector holds the
+ * latest entry. When it fills up, entries continue in the other sector, which has to be erased
+ * first; nonce_journal_maintain does that ahead of time. The old sector is only erased after
+ * the new one holds an entry, so a reset at any point leaves the latest reservation readable.
+ */
+
+// Finds the latest entry. Called on first use by the other functions.
+int nonce_journal_init();
+
+// Reads the latest value appended, or returns MBED_ERROR_ITEM_NOT_FOUND if there is none
+int nonce_journal_read(uint32_t *value);
+
+// Appends 'value'; it is the one nonce_journal_read returns from then on, including after a reset
+int nonce_journal_append(uint32_t value);
+
+// Erases the spare sector if it needs it, so that an append never has to
+int nonce_journal_maintain();
+
+#endif
@@ -0,0 +1,128 @@
+#include "presign.h"
+#include "mbed.h"
+#include "mbed_error.h"
+#include "ethers.h"
+#include "storage.h"
+#include "claims.h"
+
+#include <string.h>
+
+typedef struct {
+    bool valid;
+    uint32_t nonce;
+    address_t validator;
+    hash_t messagehash;         // Auth message the presignature is for
+    presig_t presig;
+} presign_entry_t;
+
+// Hashed to get the seed of a presignature. The tag keeps the seed apart from the hashes
+// of the auth messages, which start with 0x19 0x00.
+typedef struct {
+    char tag[8];
+    hash_t messagehash;
+} presign_seed_t;
+
+#if PRESIGN_POOL_SIZE > 0
+
+presign_entry_t presign_pool[PRESIGN_POOL_SIZE];
+
+static void wipe_entry(presign_entry_t *entry) {
+    memset(entry, 0, sizeof(presign_entry_t));
+}
+
+static presign_entry_t *find_entry(uint32_t nonce) {
+    for(int i = 0; i < PRESIGN_POOL_SIZE; i++) {
+        if(presign_pool[i].valid && presign_pool[i].nonce == nonce) {
+            return &presign_pool[i];
+        }
+    }
+    return NULL;
+}
+
+int presign_refill(privkey_t issuer_key, address_t validator) {
+    uint32_t next_nonce;
+    int ret = peek_next_nonce(&next_nonce);
+    if(ret != MBED_SUCCESS) {
+        return ret;
+    }
+
+    // Drop entries whose nonce has already been used, or that were made for another validator
+    for(int i = 0; i < PRESIGN_POOL_SIZE; i++) {
+        if(presign_pool[i].valid && (presign_pool[i].nonce - next_nonce >= PRESIGN_POOL_SIZE ||
+                memcmp(presign_pool[i].validator, validator, sizeof(address_t)) != 0)) {
+            wipe_entry(&presign_pool[i]);
+        }
+    }
+
+    for(uint32_t i = 0; i < PRESIGN_POOL_SIZE; i++) {
+        uint32_t nonce = next_nonce + i;
+        if(find_entry(nonce) != NULL) {
+            continue;
+        }
+
+        // There are fewer valid entries than upcoming nonces, so a free one exists
+        presign_entry_t *entry = presign_pool;
+        while(entry->valid) {
+            entry++;
+        }
+
+        // The seed covers the whole message, claimant included: resetting the store can
+        // give a nonce a new claim seed, and so a new message, and k must not be reused
+        presign_seed_t seed_message;
+        hash_t seed;
+        memset(&seed_message, 0, sizeof(seed_message));
+        strcpy(seed_message.tag, "presign");
+        ret = get_claim_hash(validator, nonce, seed_message.messagehash);
+        if(ret != MBED_SUCCESS) {
+            return ret;
+        }
+        ethers_keccak256_short((uint8_t*)&seed_message, sizeof(seed_message), seed);
+
+        if(!ethers_presign(issuer_key, seed, entry->presig)) {
+            wipe_entry(entry);
+            return MBED_ERROR_FAILED_OPERATION;
+        }
+        entry->nonce = nonce;
+        memcpy(entry->validator, validator, sizeof(address_t));
+        memcpy(entry->messagehash, seed_message.messagehash, sizeof(hash_t));
+        entry->valid = true;
+        return 1;
+    }
+
+    return 0;
+}
+
+bool presign_take(uint32_t nonce, hash_t messagehash, presig_t presig) {
+    presign_entry_t *entry = find_entry(nonce);
+    if(entry == NULL) {
+        return false;
+    }
+
+    bool usable = memcmp(entry->messagehash, messagehash, sizeof(hash_t)) == 0;
+    if(usable) {
+        memcpy(presig, entry->presig, sizeof(presig_t));
+    }
+    wipe_entry(entry);
+    return usable;
+}
+
+void presign_reset() {
+    for(int i = 0; i < PRESIGN_POOL_SIZE; i++) {
+        wipe_entry(&presign_pool[i]);
+    }
+}
+
+#else
+
+int presign_refill(privkey_t issuer_key, address_t validator) {
+    return 0;
+}
+
+bool presign_take(uint32_t nonce, hash_t messagehash, presig_t presig) {
+    return false;
+}
+
+void presign_reset() {
+}
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef PRESIGN_H
+#define PRESIGN_H
+
+#include <stdint.h>
+#include "types.h"
+
+#ifdef MBED_CONF_APP_PRESIGN_POOL_SIZE
+#define PRESIGN_POOL_SIZE MBED_CONF_APP_PRESIGN_POOL_SIZE
+#else
+#define PRESIGN_POOL_SIZE 4
+#endif
+
+/**
+ * Keeps presignatures (r, 1/k) for the next PRESIGN_POOL_SIZE claim nonces, so that signing a
+ * claim only takes a few modular multiplications.
+ *
+ * The nonce k of each entry is derived from the issuer key and the hash of the auth message it
+ * will sign, which covers the validator, the claim nonce and the claimant address. So a k is
+ * only ever used for one message, even if a claim nonce comes round again with another claim
+ * seed, and each entry is wiped when it is taken.
+ */
+
+/**
+ * Computes one missing presignature. Returns 1 if an entry was added, 0 if the pool is full,
+ * or an error code.
+ */
+int presign_refill(privkey_t issuer_key, address_t validator);
+
+/**
+ * Moves the presignature for 'nonce' into 'presig' and wipes it from the pool. Returns false if
+ * there is none, or it was made for another auth message than 'messagehash', in which case the
+ * claim must be signed the normal way.
+ */
+bool presign_take(uint32_t nonce, hash_t messagehash, presig_t presig);
+
+/**
+ * Wipes the pool; needed whenever the issuer key or the validator changes.
+ */
+void presign_reset();
+
+#endif
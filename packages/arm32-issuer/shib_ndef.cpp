@@ -5,13 +5,13 @@
 
 using mbed::Span;
 
-int write_ndef_record(uint8_t *out, int outlen, uint8_t flags, Span<uint8_t> type, Span<uint8_t> payload, Span<uint8_t> id) {
+int write_ndef_record_header(uint8_t *out, int outlen, uint8_t flags, Span<uint8_t> type, int payload_length, Span<uint8_t> id) {
     int off = 0;
-    if(payload.size() < 256) {
+    if(payload_length < 256) {
         if(outlen < 4) return -1;
         out[0] = flags | NDEF_SHORT_RECORD | (id.size() > 0 ? NDEF_ID_LENGTH_PRESENT : 0);
         out[1] = type.size();
-        out[2] = payload.size();
+        out[2] = payload_length;
         off += 3;
         if(id.size() > 0) {
             out[3] = id.size();
@@ -20,7 +20,6 @@ int write_ndef_record(uint8_t *out, int outlen, uint8_t flags, Span<uint8_t> typ
     } else {
         if(outlen < 7) return -1;
         out[0] = flags | (id.size() > 0 ? NDEF_ID_LENGTH_PRESENT : 0);
-        int payload_length = payload.size();
         out[1] = type.size();
         out[2] = payload_length >> 24;
         out[3] = (payload_length >> 16) & 0xff;
@@ -32,12 +31,18 @@ int write_ndef_record(uint8_t *out, int outlen, uint8_t flags, Span<uint8_t> typ
             off += 1;
         }
     }
-    if(outlen < off + type.size() + payload.size() + id.size()) return -1;
+    if(outlen < off + type.size() + id.size()) return -1;
     memcpy(out + off, type.data(), type.size());
     off += type.size();
-    memcpy(out + off, payload.data(), payload.size());
-    off += payload.size();
     memcpy(out + off, id.data(), id.size());
     off += id.size();
     return off;
 }
+
+int write_ndef_record(uint8_t *out, int outlen, uint8_t flags, Span<uint8_t> type, Span<uint8_t> payload, Span<uint8_t> id) {
+    int off = write_ndef_record_header(out, outlen, flags, type, payload.size(), id);
+    if(off < 0 || outlen < off + payload.size()) return -1;
+    memcpy(out + off, payload.data(), payload.size());
+    off += payload.size();
+    return off;
+}
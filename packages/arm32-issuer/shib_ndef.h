@@ -19,4 +19,9 @@ using mbed::Span;
 
 int write_ndef_record(uint8_t *out, int outlen, uint8_t flags, Span<uint8_t> type, Span<uint8_t> payload, Span<uint8_t> id);
 
+// Writes the part of a record that precedes its payload (header, type and id), so the payload
+// can be sent separately. The longest header is NDEF_MAX_RECORD_HEADER + type and id.
+#define NDEF_MAX_RECORD_HEADER 7
+int write_ndef_record_header(uint8_t *out, int outlen, uint8_t flags, Span<uint8_t> type, int payload_length, Span<uint8_t> id);
+
 #endif
\ No newline at end of file
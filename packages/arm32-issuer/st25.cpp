@@ -1,6 +1,5 @@
 #import "st25.h"
 #include <arm_acle.h>
-#include <alloca.h>
 
 #define CC_MAGIC_NUMBER_SHORT 0xE1
 #define CC_MAGIC_NUMBER_LONG 0xE2
@@ -10,10 +9,16 @@
 #define CC_ANDROID_RFU 0x04
 #define CC_SPECIAL_FRAME 0x10
 
+#define TLV_NDEF 0x03
+#define TLV_PROPRIETARY 0xFD
+#define TLV_TERMINATOR 0xFE
+
 #define ADDRESS_USER_MEM 0xA6
 #define ADDRESS_REGISTERS 0xAE
 
-ST25::ST25(PinName sda, PinName scl) : i2c(sda, scl) {}
+#define ST25_FLAG_TRANSFER_DONE 0x1
+
+ST25::ST25(PinName sda, PinName scl) : i2c(sda, scl), slot_size(0), active_slot(-1), shadow_size(0), shadow_valid(false), stats() {}
 
 int write_capability_container(uint8_t *out, uint16_t mlen, bool readonly, bool mbread) {
     out[0] = CC_MAGIC_NUMBER_SHORT;
@@ -38,7 +43,13 @@ int ST25::format(uint16_t mlen, bool readonly, bool mbread) {
 }
 
 int ST25::read(uint8_t *data, uint16_t len, uint16_t addr) {
-    return read(data, len, addr, ADDRESS_USER_MEM);
+    int ret = read(data, len, addr, ADDRESS_USER_MEM);
+    if(ret == 0 && shadow_valid && addr < shadow_size) {
+        // Keeps the shadow up to date with anything written over RF in that range
+        uint16_t n = addr + len <= shadow_size ? len : shadow_size - addr;
+        memcpy(shadow + addr, data, n);
+    }
+    return ret;
 }
 
 int ST25::read_register(uint16_t addr) {
@@ -60,7 +71,128 @@ int ST25::read_dynamic_register(uint16_t addr) {
 }
 
 int ST25::write(const Span<const uint8_t> &data, uint16_t addr) {
-    return write(data, addr, ADDRESS_USER_MEM);
+    return write_parts(st25_parts_t(&data, 1), addr);
+}
+
+int ST25::write_parts(const st25_parts_t &parts, uint16_t addr) {
+    return write_user(parts, 0, parts_size(parts), addr);
+}
+
+size_t ST25::parts_size(const st25_parts_t &parts) {
+    size_t size = 0;
+    for(size_t i = 0; i < parts.size(); i++) {
+        size += parts[i].size();
+    }
+    return size;
+}
+
+// Copies 'len' bytes, starting 'offset' bytes into the concatenation of 'parts', to 'out'
+void ST25::parts_copy(uint8_t *out, const st25_parts_t &parts, size_t offset, size_t len) {
+    for(size_t i = 0; i < parts.size() && len > 0; i++) {
+        size_t size = parts[i].size();
+        if(offset >= size) {
+            offset -= size;
+            continue;
+        }
+        size_t n = size - offset < len ? size - offset : len;
+        memcpy(out, parts[i].data() + offset, n);
+        out += n;
+        len -= n;
+        offset = 0;
+    }
+}
+
+// Writes 'len' bytes from 'offset' in 'parts' to user memory at 'addr'
+int ST25::write_user(const st25_parts_t &parts, size_t offset, uint16_t len, uint16_t addr) {
+    if(addr < ST25_SHADOW_SIZE && fill_shadow() == 0 && addr < shadow_size) {
+        if(addr + len <= shadow_size) {
+            return write_changed_rows(parts, offset, len, addr);
+        }
+        // Runs past the shadow; the part it covers goes through it, so it stays up to date
+        uint16_t covered = shadow_size - addr;
+        int ret = write_changed_rows(parts, offset, covered, addr);
+        if(ret != 0) {
+            return ret;
+        }
+        return write(parts, offset + covered, len - covered, shadow_size, ADDRESS_USER_MEM);
+    }
+    return write(parts, offset, len, addr, ADDRESS_USER_MEM);
+}
+
+// Reads the shadowed part of user memory, unless the shadow already holds it
+int ST25::fill_shadow() {
+    if(shadow_valid) {
+        return 0;
+    }
+    if(shadow_size == 0) {
+        int size = memory_size();
+        if(size < 0) {
+            return size;
+        }
+        shadow_size = size < ST25_SHADOW_SIZE ? size : ST25_SHADOW_SIZE;
+    }
+    if(read(shadow, shadow_size, 0x00, ADDRESS_USER_MEM) != 0) {
+        return -1;
+    }
+    shadow_valid = true;
+    return 0;
+}
+
+/*
+ * Successive NDEF messages mostly repeat the last one (the TLV and record headers, the URL prefix
+ * and the validator in the claim code), and the EEPROM spends the same ~5 ms on every 4 byte row
+ * it programs, changed or not. So user memory below ST25_SHADOW_SIZE (or all of it, on a smaller
+ * part) is kept in 'shadow', and a write only sends the runs of rows that differ from it. The
+ * shadow must be filled first.
+ */
+int ST25::write_changed_rows(const st25_parts_t &parts, size_t offset, uint16_t len, uint16_t addr) {
+    uint16_t end = addr + len;
+    uint16_t row = addr - addr % ST25_ROW_SIZE;
+    while(row < end) {
+        // Skip the unchanged rows, then find the end of the run of changed ones
+        while(row < end && !row_changed(parts, offset, addr, end, row)) {
+            row += ST25_ROW_SIZE;
+        }
+        if(row >= end) {
+            break;
+        }
+        uint16_t from = row > addr ? row : addr;
+        while(row < end && row_changed(parts, offset, addr, end, row)) {
+            row += ST25_ROW_SIZE;
+        }
+        uint16_t to = row < end ? row : end;
+
+        int ret = write(parts, offset + (from - addr), to - from, from, ADDRESS_USER_MEM);
+        if(ret != 0) {
+            // The EEPROM may hold part of the run; read it back next time
+            shadow_valid = false;
+            return ret;
+        }
+        parts_copy(shadow + from, parts, offset + (from - addr), to - from);
+    }
+    return 0;
+}
+
+// Compares the part of 'row' covered by a write to [addr, end) with the shadow
+bool ST25::row_changed(const st25_parts_t &parts, size_t offset, uint16_t addr, uint16_t end, uint16_t row) {
+    uint8_t bytes[ST25_ROW_SIZE];
+    uint16_t from = row > addr ? row : addr;
+    uint16_t to = row + ST25_ROW_SIZE < end ? row + ST25_ROW_SIZE : end;
+    parts_copy(bytes, parts, offset + (from - addr), to - from);
+    return memcmp(shadow + from, bytes, to - from) != 0;
+}
+
+void ST25::invalidate_shadow() {
+    shadow_valid = false;
+    active_slot = -1;
+}
+
+const st25_write_stats_t &ST25::write_stats() {
+    return stats;
+}
+
+void ST25::reset_write_stats() {
+    memset(&stats, 0, sizeof(stats));
 }
 
 int ST25::write_register(uint8_t data, uint16_t addr) {
@@ -72,39 +204,272 @@ int ST25::write_dynamic_register(uint8_t data, uint16_t addr) {
 }
 
 void ST25::wait() {
+    // The device NACKs its address until it has finished programming, which takes ~5 ms per
+    // row. Sleeping the thread between polls lets other threads (eg, the claim prefetch) run.
     while(true) {
         if(i2c.write(ADDRESS_USER_MEM, NULL, 0) == 0) {
             return;
         }
-        sleep();
+        ThisThread::sleep_for(1ms);
     }
 }
 
 int ST25::write_ndef(const Span<const uint8_t> &data) {
-    int len = data.size();
+    return write_ndef_parts(st25_parts_t(&data, 1));
+}
+
+/**
+ * Wraps 'parts' in an NDEF TLV. 'tlv' receives the TLV header and terminator; 'header' must have
+ * room for 4 bytes and 'all' for parts.size() + 2 entries. Returns the number of entries in 'all',
+ * or -1 if there are too many parts.
+ */
+int ST25::wrap_tlv(const st25_parts_t &parts, uint8_t *header, Span<const uint8_t> *all) {
+    static const uint8_t terminator = TLV_TERMINATOR;
+    if(parts.size() > ST25_MAX_PARTS) {
+        return -1;
+    }
+    size_t len = parts_size(parts);
+    int hdrlen;
+    header[0] = TLV_NDEF;
+    if(len < 255) {
+        header[1] = len;
+        hdrlen = 2;
+    } else {
+        header[1] = 0xFF;
+        header[2] = (len >> 8) & 0xFF;
+        header[3] = len & 0xFF;
+        hdrlen = 4;
+    }
+    all[0] = Span<const uint8_t>(header, hdrlen);
+    for(size_t i = 0; i < parts.size(); i++) {
+        all[i + 1] = parts[i];
+    }
+    all[parts.size() + 1] = Span<const uint8_t>(&terminator, 1);
+    return parts.size() + 2;
+}
+
+int ST25::write_ndef_parts(const st25_parts_t &parts) {
     int cclen = cc_length();
     if(cclen <= 0) {
         return cclen;
     }
-    if(len < 255) {
-        uint8_t *buf = (uint8_t*)alloca(len + 3);
-        buf[0] = 0x03;
-        buf[1] = len;
-        memcpy(buf + 2, data.data(), len);
-        buf[len + 2] = 0xFE;
-        return write(Span<uint8_t>(buf, len + 2), cclen);
+    uint8_t header[4];
+    Span<const uint8_t> all[ST25_MAX_PARTS + 2];
+    int count = wrap_tlv(parts, header, all);
+    if(count < 0) {
+        return -1;
+    }
+    // The terminator is left out, as it always has been for the single message
+    st25_parts_t tlv(all, count - 1);
+    return write_user(tlv, 0, parts_size(tlv), cclen);
+}
+
+
+/*
+ * With NDEF slots, the T5T area holds two TLVs of slot_size bytes each, right after the CC:
+ *
+ *   slot A: 03 <len> <NDEF message> FE ...    A is live; readers stop at the first NDEF TLV
+ *           FD FF <slot_size - 4> ...         A is hidden; readers skip the whole slot
+ *   slot B: 03 <len> <NDEF message> FE ...    B is live whenever A is hidden
+ *
+ * A new message goes into the slot readers can't see (all of B while A is live, or everything
+ * but the first block of A while A is hidden), with RF enabled. Switching to it is a single
+ * write of the first block of A (flip_ndef), which is the only time RF needs to be asleep.
+ * A must therefore start on a block boundary, which it does since the CC is 4 or 8 bytes.
+ */
+int ST25::init_ndef_slots() {
+    int cclen = cc_length();
+    if(cclen <= 0 || slot_size == 0) {
+        return -1;
+    }
+    uint16_t hidden_len = slot_size - 4;
+    uint8_t hidden[4] = {TLV_PROPRIETARY, 0xFF, (uint8_t)(hidden_len >> 8), (uint8_t)(hidden_len & 0xFF)};
+    uint8_t empty[3] = {TLV_NDEF, 0x00, TLV_TERMINATOR};
+    int ret = write(Span<uint8_t>(empty, sizeof(empty)), cclen + slot_size);
+    if(ret != 0) {
+        return ret;
+    }
+    ret = write(Span<uint8_t>(hidden, sizeof(hidden)), cclen);
+    if(ret != 0) {
+        return ret;
+    }
+    active_slot = 1;
+    return 0;
+}
+
+void ST25::set_ndef_slot_size(uint16_t size) {
+    slot_size = size;
+    active_slot = -1;
+}
+
+uint16_t ST25::ndef_slot_size() {
+    return slot_size;
+}
+
+int ST25::stage_ndef(const Span<const uint8_t> &data) {
+    return stage_ndef_parts(st25_parts_t(&data, 1));
+}
+
+int ST25::stage_ndef_parts(const st25_parts_t &parts) {
+    int cclen = cc_length();
+    if(cclen <= 0) {
+        return cclen;
+    }
+    uint8_t header[4];
+    Span<const uint8_t> all[ST25_MAX_PARTS + 2];
+    int count = wrap_tlv(parts, header, all);
+    if(count < 0) {
+        return -1;
+    }
+    st25_parts_t tlv(all, count);
+    size_t tlvlen = parts_size(tlv);
+    if(slot_size == 0 || tlvlen > slot_size) {
+        return -1;
+    }
+
+    if(active_slot < 0) {
+        uint8_t type;
+        int ret = read(&type, 1, cclen);
+        if(ret != 0) {
+            return MBED_ERROR_READ_FAILED;
+        }
+        active_slot = (type == TLV_NDEF) ? 0 : 1;
+    }
+
+    if(active_slot == 0) {
+        // B is shadowed by A, so it can be written whole; then hide A
+        int ret = write_user(tlv, 0, tlvlen, cclen + slot_size);
+        if(ret != 0) {
+            return ret;
+        }
+        uint16_t hidden_len = slot_size - 4;
+        flip_block[0] = TLV_PROPRIETARY;
+        flip_block[1] = 0xFF;
+        flip_block[2] = hidden_len >> 8;
+        flip_block[3] = hidden_len & 0xFF;
     } else {
-        uint8_t *buf = (uint8_t*)alloca(len + 5);
-        buf[0] = 0x03;
-        buf[1] = 0xFF;
-        buf[2] = (len >> 8) & 0xFF;
-        buf[3] = len & 0xFF;
-        memcpy(buf + 4, data.data(), len);
-        buf[len + 4] = 0xFE;
-        return write(Span<uint8_t>(buf, len + 4), cclen);
+        // Readers skip A by its first block; write the rest, then show A
+        int ret = write_user(tlv, 4, tlvlen - 4, cclen + 4);
+        if(ret != 0) {
+            return ret;
+        }
+        parts_copy(flip_block, tlv, 0, 4);
     }
+    return 0;
 }
 
+int ST25::flip_ndef() {
+    int cclen = cc_length();
+    if(cclen <= 0) {
+        return cclen;
+    }
+    int ret = write(Span<uint8_t>(flip_block, sizeof(flip_block)), cclen);
+    if(ret != 0) {
+        return ret;
+    }
+    active_slot ^= 1;
+    return 0;
+}
+
+/**
+ * Replaces the NDEF message readers see. RF is put to sleep while a reader could see a partly
+ * written message; with NDEF slots that is only the single block write that flips slots.
+ *
+ * Staging runs with RF enabled, so a reader that arrives meanwhile makes the device NACK it. That
+ * is retried with a back-off until the RF session ends; if it outlasts ST25_STAGE_ATTEMPTS, the
+ * message is staged with RF asleep instead, which ends the session.
+ */
+int ST25::publish_ndef_parts(const st25_parts_t &parts) {
+    bool staged = false;
+    if(slot_size != 0) {
+        auto backoff = 5ms;
+        for(int attempt = 0; attempt < ST25_STAGE_ATTEMPTS; attempt++) {
+            if(attempt > 0) {
+                ThisThread::sleep_for(backoff);
+                backoff *= 2;
+            }
+            if(stage_ndef_parts(parts) == 0) {
+                staged = true;
+                break;
+            }
+        }
+    }
+
+    int ret = write_dynamic_register(ST25_RF_SLEEP, ST25_DYN_RF_MNGT);
+    if(ret != 0) {
+        return ret;
+    }
+    if(slot_size == 0) {
+        ret = write_ndef_parts(parts);
+    } else {
+        if(!staged) {
+            ret = stage_ndef_parts(parts);
+        }
+        if(ret == 0) {
+            ret = flip_ndef();
+        }
+    }
+    int wake_ret = write_dynamic_register(0, ST25_DYN_RF_MNGT);
+    return ret != 0 ? ret : wake_ret;
+}
+
+/*
+ * The mailbox is 256 bytes of SRAM that an RF reader fetches with the ST25DV Read Message
+ * command, instead of reading the EEPROM. Host writes cost no programming time or endurance, and
+ * the mailbox empties itself when the reader has fetched the whole message (raising
+ * ST25_IT_RF_GET_MSG), so each message is handed to exactly one reader.
+ */
+
+// Turns the mailbox on, discarding anything in it. MB_EN is cleared whenever the part powers up.
+int ST25::enable_mailbox() {
+    int ret = write_dynamic_register(0, ST25_DYN_MB_CTRL);
+    if(ret != 0) {
+        return ret;
+    }
+    return write_dynamic_register(ST25_MB_EN, ST25_DYN_MB_CTRL);
+}
+
+// Puts a message in the mailbox, replacing any that is there
+int ST25::write_mailbox_parts(const st25_parts_t &parts) {
+    size_t len = parts_size(parts);
+    if(len == 0 || len > ST25_MAILBOX_SIZE) {
+        return -1;
+    }
+
+    // The device refuses to overwrite a message, whether ours or one put there over RF
+    int ret = read_dynamic_register(ST25_DYN_MB_CTRL);
+    if(ret < 0) {
+        return ret;
+    }
+    if(!(ret & ST25_MB_EN) || (ret & (ST25_MB_HOST_PUT_MSG | ST25_MB_RF_PUT_MSG))) {
+        ret = enable_mailbox();
+        if(ret != 0) {
+            return ret;
+        }
+    }
+
+    // The whole message has to go in one transaction
+    return write(parts, 0, len, ST25_MAILBOX, ADDRESS_USER_MEM);
+}
+
+// Returns 1 if the mailbox holds a message from the host that RF has not fetched yet
+int ST25::mailbox_pending() {
+    int ret = read_dynamic_register(ST25_DYN_MB_CTRL);
+    if(ret < 0) {
+        return ret;
+    }
+    return (ret & ST25_MB_EN) && (ret & ST25_MB_HOST_PUT_MSG) ? 1 : 0;
+}
+
+int ST25::memory_size() {
+    // MEM_SIZE is the number of blocks minus one (2 bytes LSB first), BLK_SIZE the block size minus one
+    uint8_t buf[3];
+    int ret = read(buf, sizeof(buf), ST25_REG_MEM_SIZE, ADDRESS_REGISTERS);
+    if(ret != 0) {
+        return MBED_ERROR_READ_FAILED;
+    }
+    return ((buf[0] | (buf[1] << 8)) + 1) * (buf[2] + 1);
+}
 
 int ST25::unlock(uint64_t passcode) {
     uint8_t buf[17];
@@ -140,18 +505,27 @@ int ST25::cc_length() {
 }
 
 int ST25::write(const Span<const uint8_t> &data, uint16_t addr, uint8_t i2c_addr) {
+    return write(st25_parts_t(&data, 1), 0, data.size(), addr, i2c_addr);
+}
+
+// Streams 'len' bytes from 'offset' in 'parts' to the device, up to 256 bytes per transaction
+int ST25::write(const st25_parts_t &parts, size_t offset, uint16_t len, uint16_t addr, uint8_t i2c_addr) {
     char buf[258];
     uint16_t idx = 0;
-    int len = data.size();
     while(len > 0) {
         uint16_t writelen = len < 256 ? len : 256;
         uint16_t st25_addr = __rev16(addr + idx);
         memcpy(buf, (char*)&st25_addr, 2);
-        memcpy(buf + 2, data.data() + idx, writelen);
-        int ret = i2c.write(i2c_addr, buf, writelen + 2);
+        parts_copy((uint8_t*)buf + 2, parts, offset + idx, writelen);
+        int ret = transfer(i2c_addr, buf, writelen + 2, NULL, 0);
         if(ret != 0) {
             return ret;
         }
+        if(i2c_addr == ADDRESS_USER_MEM && addr + idx < ST25_DYN_GPO_CTRL) {
+            uint16_t first = addr + idx;
+            stats.bytes_written += writelen;
+            stats.rows_written += (first + writelen - 1) / ST25_ROW_SIZE - first / ST25_ROW_SIZE + 1;
+        }
         idx += writelen;
         len -= writelen;
         wait();
@@ -161,9 +535,42 @@ int ST25::write(const Span<const uint8_t> &data, uint16_t addr, uint8_t i2c_addr
 
 int ST25::read(uint8_t *data, uint16_t len, uint16_t addr, uint8_t i2c_addr) {
     uint16_t st25_addr = __rev16(addr);
-    int ret = i2c.write(i2c_addr, (char*)&st25_addr, 2);
+    return transfer(i2c_addr, (char*)&st25_addr, 2, (char*)data, len);
+}
+
+/**
+ * Writes 'tx' and then, if 'rx_len' is not 0, reads 'rx' after a repeated start. With
+ * asynchronous I2C the calling thread waits on an event flag while the transfer runs under
+ * interrupts, instead of the CPU busy-waiting on the bus, for up to ST25_TRANSFER_TIMEOUT.
+ */
+int ST25::transfer(uint8_t i2c_addr, const char *tx, int tx_len, char *rx, int rx_len) {
+#if ST25_ASYNC_I2C
+    transfer_flags.clear(ST25_FLAG_TRANSFER_DONE);
+    int ret = i2c.transfer(i2c_addr, tx, tx_len, rx, rx_len, callback(this, &ST25::transfer_done), I2C_EVENT_ALL);
     if(ret != 0) {
         return ret;
     }
-    return i2c.read(i2c_addr, (char*)data, len);
-}
\ No newline at end of file
+    uint32_t flags = transfer_flags.wait_any_for(ST25_FLAG_TRANSFER_DONE, ST25_TRANSFER_TIMEOUT);
+    if(flags == osFlagsErrorTimeout) {
+        // The completion was lost (eg, the bus locked up); stop the transfer before the caller's
+        // buffers go out of scope
+        i2c.abort_transfer();
+        return -1;
+    }
+    return (transfer_event & I2C_EVENT_TRANSFER_COMPLETE) ? 0 : -1;
+#else
+    int ret = i2c.write(i2c_addr, tx, tx_len, rx_len > 0);
+    if(ret != 0 || rx_len == 0) {
+        return ret;
+    }
+    return i2c.read(i2c_addr, rx, rx_len);
+#endif
+}
+
+#if ST25_ASYNC_I2C
+// Called from interrupt context when a transfer ends
+void ST25::transfer_done(int event) {
+    transfer_event = event;
+    transfer_flags.set(ST25_FLAG_TRANSFER_DONE);
+}
+#endif
\ No newline at end of file
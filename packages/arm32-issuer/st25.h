@@ -3,6 +3,21 @@
 
 #import "mbed.h"
 
+#if ST25_MOCK_I2C
+// Host builds only; the simulated device is in host/
+#include "st25_mock_i2c.h"
+typedef MockI2C st25_i2c_t;
+#else
+typedef I2C st25_i2c_t;
+#endif
+
+// Transfers go through I2C::transfer, so the calling thread sleeps while the bus works
+#define ST25_ASYNC_I2C (DEVICE_I2C_ASYNCH || ST25_MOCK_I2C)
+
+// Longest wait for an asynchronous transfer to complete; the longest, 258 bytes at 100 kHz,
+// takes about 25 ms
+#define ST25_TRANSFER_TIMEOUT   100ms
+
 // EEPROM registers
 #define ST25_REG_GPO            0x0000
 #define ST25_REG_IT_TIME        0x0001
@@ -40,6 +55,10 @@
 #define ST25_DYN_MB_CTRL        0x2006
 #define ST25_DYN_MB_LEN         0x2007
 
+// Fast transfer mode mailbox, in SRAM after the dynamic registers
+#define ST25_MAILBOX            0x2008
+#define ST25_MAILBOX_SIZE       256
+
 // Flags for GPO register
 #define ST25_GPO_RF_USER_EN         0x01
 #define ST25_GPO_RF_ACTIVITY_EN     0x02
@@ -81,6 +100,15 @@
 #define ST25_MB_MODE_OFF            0x00
 #define ST25_MB_MODE_ON             0x01
 
+// MB_CTRL_Dyn
+#define ST25_MB_EN                  0x01
+#define ST25_MB_HOST_PUT_MSG        0x02
+#define ST25_MB_RF_PUT_MSG          0x04
+#define ST25_MB_HOST_MISS_MSG       0x10
+#define ST25_MB_RF_MISS_MSG         0x20
+#define ST25_MB_HOST_CURRENT_MSG    0x40
+#define ST25_MB_RF_CURRENT_MSG      0x80
+
 // LOCK_CFG
 #define ST25_CONFIG_UNLOCKED        0x00
 #define ST25_CONFIG_LOCKED          0x01
@@ -93,9 +121,45 @@
 #define ST25_AFI_UNLOCKED           0x00
 #define ST25_AFI_LOCKED             0x01
 
+// User memory below this address (or all of it, on smaller parts) is mirrored in RAM, so writes
+// only program the rows that change
+#define ST25_SHADOW_SIZE        0x320
+#define ST25_ROW_SIZE           4
+
+typedef struct {
+    uint32_t bytes_written;     // User memory bytes sent to the EEPROM
+    uint32_t rows_written;      // 4 byte rows programmed (about 5 ms each)
+} st25_write_stats_t;
+
+// The ST25DV NACKs I2C access to the EEPROM while an RF session is open. Staging an NDEF message
+// is tried this many times, sleeping 5 ms before the second attempt and twice as long before each
+// one after (about 0.6 s in all), before falling back to a write with RF asleep.
+#define ST25_STAGE_ATTEMPTS     8
+
+// Most parts an NDEF message can be given in
+#define ST25_MAX_PARTS          8
+
+// A byte string given as consecutive parts, which are streamed to the device without first
+// being copied into one buffer
+typedef Span<const Span<const uint8_t>> st25_parts_t;
+
 class ST25 {
-    I2C i2c;
+protected:
+    st25_i2c_t i2c;
+
+private:
+#if ST25_ASYNC_I2C
+    EventFlags transfer_flags;
+    volatile int transfer_event;
+#endif
     uint8_t cc[8];
+    uint16_t slot_size;
+    int8_t active_slot;
+    uint8_t flip_block[4];
+    uint8_t shadow[ST25_SHADOW_SIZE];
+    uint16_t shadow_size;       // Bytes shadowed: ST25_SHADOW_SIZE, or all of a smaller part
+    bool shadow_valid;
+    st25_write_stats_t stats;
     
 public:
     ST25(PinName sda, PinName scl);
@@ -105,14 +169,48 @@ public:
     int read_register(uint16_t addr);
     int read_dynamic_register(uint16_t addr);
     int write(const Span<const uint8_t> &data, uint16_t addr);
+    int write_parts(const st25_parts_t &parts, uint16_t addr);
     int write_register(uint8_t data, uint16_t addr);
     int write_dynamic_register(uint8_t data, uint16_t addr);
     int write_ndef(const Span<const uint8_t> &data);
+    int write_ndef_parts(const st25_parts_t &parts);
     int unlock(uint64_t passcode);
+    int memory_size();
+
+    // Double-buffered NDEF; see the comment above init_ndef_slots in st25.cpp
+    void set_ndef_slot_size(uint16_t size);
+    uint16_t ndef_slot_size();
+    int init_ndef_slots();
+    int stage_ndef(const Span<const uint8_t> &data);
+    int stage_ndef_parts(const st25_parts_t &parts);
+    int flip_ndef();
+    int publish_ndef_parts(const st25_parts_t &parts);
+
+    // Fast transfer mailbox; needs MB_MODE set to ST25_MB_MODE_ON
+    int enable_mailbox();
+    int write_mailbox_parts(const st25_parts_t &parts);
+    int mailbox_pending();
+
+    // Forgets the shadow copy of user memory, eg after RF writes to it
+    void invalidate_shadow();
+    const st25_write_stats_t &write_stats();
+    void reset_write_stats();
 
 private:
     int write(const Span<const uint8_t> &data, uint16_t addr, uint8_t i2c_addr);
+    int write(const st25_parts_t &parts, size_t offset, uint16_t len, uint16_t addr, uint8_t i2c_addr);
+    int write_user(const st25_parts_t &parts, size_t offset, uint16_t len, uint16_t addr);
+    int fill_shadow();
+    int write_changed_rows(const st25_parts_t &parts, size_t offset, uint16_t len, uint16_t addr);
+    bool row_changed(const st25_parts_t &parts, size_t offset, uint16_t addr, uint16_t end, uint16_t row);
+    int wrap_tlv(const st25_parts_t &parts, uint8_t *header, Span<const uint8_t> *all);
+    static size_t parts_size(const st25_parts_t &parts);
+    static void parts_copy(uint8_t *out, const st25_parts_t &parts, size_t offset, size_t len);
     int read(uint8_t *data, uint16_t len, uint16_t addr, uint8_t i2c_addr);
+    int transfer(uint8_t i2c_addr, const char *tx, int tx_len, char *rx, int rx_len);
+#if ST25_ASYNC_I2C
+    void transfer_done(int event);
+#endif
     int cc_length();
     int read_cc();
 };
@@ -5,8 +5,10 @@
 #include "config.h"
 #include "mbed_error.h"
 #include "DeviceKey.h"
+#include "nonce_journal.h"
 
 uint32_t next_nonce = 0xffffffff;
+uint32_t reserved_nonce;   // Nonces below this are reserved in storage
 
 int get_issuer_key(privkey_t privkey) {
     uint8_t salt = 0;
@@ -41,9 +43,69 @@ int get_issuer_address(address_t address) {
     return MBED_SUCCESS;
 }
 
+// The issuer address, with a tag that only matches for the issuer key it was computed from
+typedef struct {
+    address_t address;
+    hash_t tag;
+} issuer_cache_t;
+
+static void issuer_cache_tag(privkey_t privkey, address_t address, hash_t tag) {
+    struct {
+        char domain[16];
+        privkey_t privkey;
+        address_t address;
+    } message;
+    memset(&message, 0, sizeof(message));
+    strcpy(message.domain, "issuer cache v1");
+    memcpy(message.privkey, privkey, sizeof(privkey_t));
+    memcpy(message.address, address, sizeof(address_t));
+    ethers_keccak256_short((uint8_t*)&message, sizeof(message), tag);
+    memset(&message, 0, sizeof(message));
+}
+
+int load_issuer(privkey_t privkey, address_t address) {
+    int ret = get_issuer_key(privkey);
+    if(ret != MBED_SUCCESS) {
+        return ret;
+    }
+
+    issuer_cache_t cache;
+    hash_t tag;
+    size_t cache_size;
+    ret = kv_get(ISSUER_CACHE_KEY_PATH, &cache, sizeof(cache), &cache_size);
+    if(ret == MBED_SUCCESS && cache_size == sizeof(cache)) {
+        issuer_cache_tag(privkey, cache.address, tag);
+        if(memcmp(tag, cache.tag, sizeof(hash_t)) == 0) {
+            memcpy(address, cache.address, sizeof(address_t));
+            return MBED_SUCCESS;
+        }
+    }
+
+    // No cache, or it is corrupt or for another key; compute the address and cache it
+    if(!ethers_privateKeyToAddress(privkey, address)) {
+        return MBED_ERROR_FAILED_OPERATION;
+    }
+    memcpy(cache.address, address, sizeof(address_t));
+    issuer_cache_tag(privkey, address, cache.tag);
+    ret = kv_set(ISSUER_CACHE_KEY_PATH, &cache, sizeof(cache), 0);
+    if(ret != MBED_SUCCESS) {
+        // Not fatal; the address is computed again on the next boot
+        printf("Caching issuer address failed: %d\n", ret);
+    }
+    return MBED_SUCCESS;
+}
+
 int get_stored_nonce(uint32_t *nonce) {
+    int ret;
+#if NONCE_JOURNAL
+    ret = nonce_journal_read(nonce);
+    if(ret != MBED_ERROR_ITEM_NOT_FOUND) {
+        return ret;
+    }
+    // Nothing in the journal yet; carry on from the nonce in KVStore, if there is one
+#endif
     size_t key_size;
-    int ret = kv_get(NEXT_NONCE_KEY_PATH, nonce, sizeof(uint32_t), &key_size);
+    ret = kv_get(NEXT_NONCE_KEY_PATH, nonce, sizeof(uint32_t), &key_size);
     if(ret == MBED_ERROR_ITEM_NOT_FOUND) {
         *nonce = 0;
         ret = MBED_SUCCESS;
@@ -52,32 +114,143 @@ int get_stored_nonce(uint32_t *nonce) {
 }
 
 int set_stored_nonce(uint32_t nonce) {
+#if NONCE_JOURNAL
+    return nonce_journal_append(nonce);
+#else
     return kv_set(NEXT_NONCE_KEY_PATH, &nonce, sizeof(uint32_t), 0);
+#endif
+}
+
+int get_seed_prf_start(uint32_t *nonce) {
+    size_t key_size;
+    int ret = kv_get(SEED_PRF_START_KEY_PATH, nonce, sizeof(uint32_t), &key_size);
+    if(ret != MBED_ERROR_ITEM_NOT_FOUND) {
+        return ret;
+    }
+
+    // First boot with PRF seeds: nonces from here on have not been handed out yet
+    ret = peek_next_nonce(nonce);
+    if(ret != MBED_SUCCESS) {
+        return ret;
+    }
+    return kv_set(SEED_PRF_START_KEY_PATH, nonce, sizeof(uint32_t), 0);
 }
 
 int reset_store() {
-    return kv_reset("/kv");
+    // The first PRF seed nonce is kept, or nonces before it would change seeds after the reset
+    uint32_t seed_prf_start;
+    size_t key_size;
+    int found = kv_get(SEED_PRF_START_KEY_PATH, &seed_prf_start, sizeof(uint32_t), &key_size);
+    if(found != MBED_SUCCESS && found != MBED_ERROR_ITEM_NOT_FOUND) {
+        return found;
+    }
+
+    // Boot times are about the hardware, not the configuration
+    boot_stats_t stats;
+    int stats_found = kv_get(BOOT_STATS_KEY_PATH, &stats, sizeof(stats), &key_size);
+    if(stats_found == MBED_SUCCESS && key_size != sizeof(stats)) {
+        stats_found = MBED_ERROR_ITEM_NOT_FOUND;
+    }
+
+    // The nonce journal is kept: the issuer key is derived from the device key, and survives this
+    int ret = kv_reset("/kv");
+    if(ret != MBED_SUCCESS) {
+        return ret;
+    }
+    if(stats_found == MBED_SUCCESS) {
+        ret = kv_set(BOOT_STATS_KEY_PATH, &stats, sizeof(stats), 0);
+        if(ret != MBED_SUCCESS) {
+            return ret;
+        }
+    }
+    if(found != MBED_SUCCESS) {
+        return MBED_SUCCESS;
+    }
+    return kv_set(SEED_PRF_START_KEY_PATH, &seed_prf_start, sizeof(uint32_t), 0);
 }
 
-int get_next_nonce(uint32_t *nonce) {
+int record_boot_time(uint32_t init_ms, uint32_t first_claim_ms, boot_stats_t *stats) {
+    size_t key_size;
+    int ret = kv_get(BOOT_STATS_KEY_PATH, stats, sizeof(boot_stats_t), &key_size);
+    if(ret == MBED_ERROR_ITEM_NOT_FOUND || (ret == MBED_SUCCESS && key_size != sizeof(boot_stats_t))) {
+        // First boot recorded, or stats from another version; start again
+        memset(stats, 0, sizeof(boot_stats_t));
+    } else if(ret != MBED_SUCCESS) {
+        return ret;
+    }
+
+    if(stats->boots == 0 || first_claim_ms < stats->best_ms) {
+        stats->best_ms = first_claim_ms;
+    }
+    if(stats->boots == 0 || first_claim_ms > stats->worst_ms) {
+        stats->worst_ms = first_claim_ms;
+    }
+    stats->boots += 1;
+    stats->last_init_ms = init_ms;
+    stats->last_ms = first_claim_ms;
+    return kv_set(BOOT_STATS_KEY_PATH, stats, sizeof(boot_stats_t), 0);
+}
+
+int maintain_store() {
+    int ret = reserve_nonces();
+    if(ret != MBED_SUCCESS) {
+        return ret;
+    }
+#if NONCE_JOURNAL
+    return nonce_journal_maintain();
+#else
+    return MBED_SUCCESS;
+#endif
+}
+
+int peek_next_nonce(uint32_t *nonce) {
     if(next_nonce == 0xffffffff) {
         int ret = get_stored_nonce(&next_nonce);
         if(ret != MBED_SUCCESS) {
             return ret;
         }
+        reserved_nonce = next_nonce;
     }
 
     *nonce = next_nonce;
+    return MBED_SUCCESS;
+}
 
-    if((next_nonce & 0xff) == 0) {
-        // We're about to start a new block of nonces; update storage
-        int ret = set_stored_nonce(next_nonce + 256);
-        if(ret != MBED_SUCCESS) {
-            return ret;
-        }
+// Reserves another block in storage if fewer than 'low_watermark' reserved nonces are left
+static int extend_reservation(uint32_t low_watermark) {
+    if(reserved_nonce - next_nonce >= low_watermark) {
+        return MBED_SUCCESS;
+    }
+    int ret = set_stored_nonce(reserved_nonce + NONCE_BLOCK_SIZE);
+    if(ret != MBED_SUCCESS) {
+        return ret;
+    }
+    reserved_nonce += NONCE_BLOCK_SIZE;
+    return MBED_SUCCESS;
+}
+
+int get_next_nonce(uint32_t *nonce) {
+    int ret = peek_next_nonce(nonce);
+    if(ret != MBED_SUCCESS) {
+        return ret;
+    }
+
+    // Normally reserve_nonces has extended the reservation ahead of time; if not, do it now
+    ret = extend_reservation(1);
+    if(ret != MBED_SUCCESS) {
+        return ret;
     }
 
     next_nonce++;
 
     return MBED_SUCCESS;
 }
+
+int reserve_nonces() {
+    uint32_t nonce;
+    int ret = peek_next_nonce(&nonce);
+    if(ret != MBED_SUCCESS) {
+        return ret;
+    }
+    return extend_reservation(NONCE_LOW_WATERMARK);
+}
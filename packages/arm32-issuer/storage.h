@@ -3,12 +3,60 @@
 #include "types.h"
 #include <stdint.h>
 
+// Nonces are reserved in storage a block at a time, so that they are never reused after a reset
+#define NONCE_BLOCK_SIZE 256
+
+// Once fewer nonces than this are left in the reservation, reserve_nonces adds the next block
+#ifdef MBED_CONF_APP_NONCE_LOW_WATERMARK
+#define NONCE_LOW_WATERMARK MBED_CONF_APP_NONCE_LOW_WATERMARK
+#else
+#define NONCE_LOW_WATERMARK 64
+#endif
+
+#if NONCE_LOW_WATERMARK < 1 || NONCE_LOW_WATERMARK > NONCE_BLOCK_SIZE
+#error "nonce-low-watermark must be between 1 and the nonce block size"
+#endif
+
+// Clears the store, apart from the first PRF seed nonce
 int reset_store();
 
+// Housekeeping that would otherwise delay a later call, such as reserving nonces or erasing
+// flash; run when idle
+int maintain_store();
+
 int get_issuer_key(privkey_t privkey);
 
 int get_issuer_address(address_t address);
 
+// Gets the issuer key and address. The address is cached in storage, so that it only has to be
+// computed from the key once.
+int load_issuer(privkey_t privkey, address_t address);
+
+// Times from power-on to the first claim code written, over the boots recorded so far
+typedef struct {
+    uint32_t boots;
+    uint32_t last_init_ms;      // initialize_device's share of last_ms
+    uint32_t last_ms;
+    uint32_t best_ms;
+    uint32_t worst_ms;
+} boot_stats_t;
+
+// Adds a boot's times to the stats in storage, and returns the updated stats. reset_store keeps
+// them, so that they can be compared across a reset.
+int record_boot_time(uint32_t init_ms, uint32_t first_claim_ms, boot_stats_t *stats);
+
 int get_next_nonce(uint32_t *nonce);
 
+// Returns the nonce the next call to get_next_nonce will hand out, without using it up.
+int peek_next_nonce(uint32_t *nonce);
+
+// Returns the first nonce whose claim seed comes from the keccak PRF (see claim_seed.h). It is
+// recorded the first time this is called, as the next nonce to be handed out, and reset_store
+// keeps it.
+int get_seed_prf_start(uint32_t *nonce);
+
+// Reserves the next block of nonces in storage once the reservation runs low, so that
+// get_next_nonce only has to write to storage if this has not been called in time.
+int reserve_nonces();
+
 #endif
\ No newline at end of file
@@ -11,5 +11,6 @@ typedef uint8_t privkey_t[ETHERS_PRIVATEKEY_LENGTH];
 typedef uint8_t pubkey_t[ETHERS_PUBLICKEY_LENGTH];
 typedef uint8_t sig_t[64];
 typedef uint8_t seed_t[SEED_LENGTH];
+typedef uint8_t presig_t[ETHERS_PRESIGNATURE_LENGTH];
 
 #endif
\ No newline at end of file